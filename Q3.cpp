@@ -9,6 +9,27 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+// result cache
+#include <filesystem>
+#include <cstdint>
+// pipeline stages
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+// k shortest paths
+#include <future>
+#include <atomic>
+#include <set>
+#include <tuple>
+#include <unordered_set>
+#include <climits>
+// euclidean mst
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <functional>
+// compressed graph
+#include <cstring>
 
 using namespace std;
 using namespace chrono;
@@ -26,6 +47,46 @@ struct Edge
     int distance;
 };
 
+// parse a single dataset line into a star or an edge, readingEdges flips once the routes header is seen
+void parseLine(const string &line, bool &readingEdges, vector<Star> &stars, vector<Edge> &edges)
+{
+    if (line.empty())
+        return;
+
+    // if true, read route data (edges)
+    if (line == "Routes (edges):")
+    {
+        readingEdges = true;
+        return;
+    }
+    // if false, read star data (vertices)
+    if (!readingEdges)
+    {
+        Star star;
+        istringstream iss(line);
+        string temp;
+
+        // Parse star data
+        getline(iss, star.name, '\t');
+        iss >> star.x >> star.y >> star.z >> star.weight >> star.profit;
+
+        stars.push_back(star);
+    }
+    else
+    {
+        Edge edge;
+        istringstream iss(line);
+        string temp;
+
+        // Parse edge data
+        // temp to replace symbols
+        getline(iss, edge.star1, ' ');
+        iss >> edge.star1 >> temp >> temp >> edge.star2 >> temp >> edge.distance;
+
+        edges.push_back(edge);
+    }
+}
+
 void fileReader(const string &dataSet2, vector<Star> &stars, vector<Edge> &edges)
 {
     // error handling
@@ -42,43 +103,404 @@ void fileReader(const string &dataSet2, vector<Star> &stars, vector<Edge> &edges
 
     while (getline(file, line))
     {
-        if (line.empty())
-            continue;
+        parseLine(line, readingEdges, stars, edges);
+    }
+    file.close();
+}
+
+// Pipeline
+// read -> parse -> build run on their own threads connected by bounded queues,
+// results are handed to a writer thread so printing overlaps with the next computation
+double msSince(const high_resolution_clock::time_point &start)
+{
+    duration<double, milli> elapsed = high_resolution_clock::now() - start;
+    return elapsed.count();
+}
+
+// time each stage spent doing work (not waiting on its neighbours)
+struct StageTimes
+{
+    double read = 0.0, parse = 0.0, build = 0.0, solve = 0.0, write = 0.0;
+};
+
+void printStageTimes(const StageTimes &times)
+{
+    cout << "Stage times: read " << times.read << " ms, parse " << times.parse << " ms, build " << times.build
+         << " ms, solve " << times.solve << " ms, write " << times.write << " ms" << endl;
+}
+
+// push blocks while the queue is full so a fast stage cannot run far ahead of a slow one
+template <typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+    void push(T item)
+    {
+        unique_lock<mutex> lock(m);
+        notFull.wait(lock, [this]
+                     { return items.size() < capacity; });
+        items.push(move(item));
+        notEmpty.notify_one();
+    }
 
-        // if true, read route data (edges)
-        if (line == "Routes (edges):")
+    // returns false once the queue is closed and fully drained
+    bool pop(T &item)
+    {
+        unique_lock<mutex> lock(m);
+        notEmpty.wait(lock, [this]
+                      { return !items.empty() || closed; });
+        if (items.empty())
         {
-            readingEdges = true;
-            continue;
+            return false;
+        }
+        item = move(items.front());
+        items.pop();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        lock_guard<mutex> lock(m);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    queue<T> items;
+    bool closed = false;
+    mutex m;
+    condition_variable notEmpty, notFull;
+};
+
+// streams the dataset through read and parse threads, the calling thread hands each chunk of routes to consume
+void pipelinedReader(const string &dataSet2, vector<Star> &stars, const function<void(const vector<Edge> &)> &consume, StageTimes &times)
+{
+    ifstream file(dataSet2);
+    if (!file.is_open())
+    {
+        cerr << "Error opening txt file" << endl;
+        exit(1);
+    }
+    const size_t CHUNK_LINES = 1024;
+    BoundedQueue<vector<string>> lineQueue(8);
+    BoundedQueue<vector<Edge>> edgeQueue(8);
+
+    // stage 1: read raw lines in chunks
+    thread reader([&]()
+                  {
+        string line;
+        // skip header
+        getline(file, line);
+        vector<string> chunk;
+        auto start = high_resolution_clock::now();
+        while (getline(file, line))
+        {
+            chunk.push_back(line);
+            if (chunk.size() == CHUNK_LINES)
+            {
+                times.read += msSince(start);
+                lineQueue.push(move(chunk));
+                chunk.clear();
+                start = high_resolution_clock::now();
+            }
+        }
+        times.read += msSince(start);
+        if (!chunk.empty())
+        {
+            lineQueue.push(move(chunk));
+        }
+        lineQueue.close(); });
+
+    // stage 2: parse chunks, stars are kept here and edges move on to the builder
+    thread parser([&]()
+                  {
+        bool readingEdges = false;
+        vector<string> chunk;
+        while (lineQueue.pop(chunk))
+        {
+            auto start = high_resolution_clock::now();
+            vector<Edge> parsed;
+            for (const auto &line : chunk)
+            {
+                parseLine(line, readingEdges, stars, parsed);
+            }
+            times.parse += msSince(start);
+            if (!parsed.empty())
+            {
+                edgeQueue.push(move(parsed));
+            }
         }
-        // if false, read star data (vertices)
-        if (!readingEdges)
+        edgeQueue.close(); });
+
+    // stage 3: consume chunks as they arrive
+    vector<Edge> chunk;
+    while (edgeQueue.pop(chunk))
+    {
+        auto start = high_resolution_clock::now();
+        consume(chunk);
+        times.build += msSince(start);
+    }
+
+    reader.join();
+    parser.join();
+}
+
+// builds the edge list and adjacency list from the streamed chunks
+void pipelinedReader(const string &dataSet2, vector<Star> &stars, vector<Edge> &edges, unordered_map<string, vector<pair<string, int>>> &adj, bool buildAdjacency, StageTimes &times)
+{
+    pipelinedReader(
+        dataSet2, stars, [&](const vector<Edge> &chunk)
         {
-            Star star;
-            istringstream iss(line);
-            string temp;
+            for (const auto &edge : chunk)
+            {
+                if (buildAdjacency)
+                {
+                    adj[edge.star1].push_back(make_pair(edge.star2, edge.distance));
+                }
+                edges.push_back(edge);
+            } },
+        times);
+}
+
+// writer stage, the solver thread formats text and this thread does the blocking console and file writes
+class AsyncWriter
+{
+public:
+    AsyncWriter(const string &fileName) : outputFile(fileName), lines(256), worker([this]
+                                                                                   { run(); }) {}
+
+    ~AsyncWriter()
+    {
+        finish();
+    }
 
-            // Parse star data
-            getline(iss, star.name, '\t');
-            iss >> star.x >> star.y >> star.z >> star.weight >> star.profit;
+    void emit(string console, string file)
+    {
+        lines.push(make_pair(move(console), move(file)));
+    }
 
-            stars.push_back(star);
+    // wait for everything queued so far to be written
+    void finish()
+    {
+        if (worker.joinable())
+        {
+            lines.close();
+            worker.join();
         }
-        else
+    }
+
+    double busyMs() const
+    {
+        return busy;
+    }
+
+private:
+    void run()
+    {
+        pair<string, string> line;
+        while (lines.pop(line))
         {
-            Edge edge;
-            istringstream iss(line);
-            string temp;
+            auto start = high_resolution_clock::now();
+            cout << line.first;
+            outputFile << line.second;
+            busy += msSince(start);
+        }
+        cout.flush();
+        outputFile.flush();
+    }
+
+    ofstream outputFile;
+    BoundedQueue<pair<string, string>> lines;
+    double busy = 0.0;
+    // declared last so the thread starts after the members it uses
+    thread worker;
+};
+
+// Result cache
+// results are stored on disk keyed by algorithm, parameters and a hash of the dataset bytes
+// so a rerun on an unchanged dataset skips parsing and solving entirely
+const string CACHE_DIR = "result_cache";
+const size_t CACHE_MAX_ENTRIES = 32;
+// part of every key, bump it whenever a solver or a serialize format changes so old entries stop matching
+const string CACHE_VERSION = "v4";
 
-            // Parse edge data
-            // temp to replace symbols
-            getline(iss, edge.star1, ' ');
-            iss >> edge.star1 >> temp >> temp >> edge.star2 >> temp >> edge.distance;
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
 
-            edges.push_back(edge);
+// FNV-1a hash of the raw dataset file, changes whenever any byte of the dataset changes
+string datasetFingerprint(const string &dataSet2)
+{
+    ifstream file(dataSet2, ios::binary);
+    if (!file.is_open())
+    {
+        cerr << "Error opening txt file" << endl;
+        exit(1);
+    }
+    uint64_t hash = FNV_OFFSET;
+    char buffer[4096];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+    {
+        for (streamsize i = 0; i < file.gcount(); i++)
+        {
+            hash ^= static_cast<unsigned char>(buffer[i]);
+            hash *= FNV_PRIME;
         }
     }
+    ostringstream oss;
+    oss << hex << hash;
+    return oss.str();
+}
+
+string cachePath(const string &algo, const string &params, const string &fingerprint)
+{
+    return CACHE_DIR + "/" + algo + "_" + params + "_" + fingerprint + "_" + CACHE_VERSION + ".txt";
+}
+
+// FNV-1a of an entry's contents, stored in its first line so a torn or truncated entry is detected
+string contentsChecksum(const string &contents)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (char c : contents)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= FNV_PRIME;
+    }
+    ostringstream oss;
+    oss << hex << hash;
+    return oss.str();
+}
+
+bool cacheRead(const string &algo, const string &params, const string &fingerprint, string &contents)
+{
+    string path = cachePath(algo, params, fingerprint);
+    ifstream file(path, ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    // first line is "checksum size", the contents follow
+    string header, checksum;
+    size_t size = 0;
+    getline(file, header);
+    istringstream(header) >> checksum >> size;
+    ostringstream oss;
+    oss << file.rdbuf();
+    contents = oss.str();
     file.close();
+    error_code ec;
+    if (checksum.empty() || contents.size() != size || contentsChecksum(contents) != checksum)
+    {
+        // a damaged entry is a miss, remove it so the next run rewrites it
+        filesystem::remove(path, ec);
+        contents.clear();
+        return false;
+    }
+    // touch the entry so it counts as most recently used
+    filesystem::last_write_time(path, filesystem::file_time_type::clock::now(), ec);
+    return true;
+}
+
+void cacheWrite(const string &algo, const string &params, const string &fingerprint, const string &contents)
+{
+    error_code ec;
+    filesystem::create_directories(CACHE_DIR, ec);
+
+    // drop entries of the same query computed from an older dataset or cache version
+    string prefix = algo + "_" + params + "_";
+    string current = filesystem::path(cachePath(algo, params, fingerprint)).filename().string();
+    vector<pair<filesystem::file_time_type, filesystem::path>> entries;
+    for (const auto &entry : filesystem::directory_iterator(CACHE_DIR, ec))
+    {
+        string name = entry.path().filename().string();
+        if (name.rfind(prefix, 0) == 0 && name != current)
+        {
+            filesystem::remove(entry.path(), ec);
+            continue;
+        }
+        entries.push_back(make_pair(entry.last_write_time(ec), entry.path()));
+    }
+
+    // LRU eviction, remove least recently used entries until there is room for the new one
+    sort(entries.begin(), entries.end());
+    for (size_t i = 0; i + CACHE_MAX_ENTRIES <= entries.size(); i++)
+    {
+        filesystem::remove(entries[i].second, ec);
+    }
+
+    // write a private temp file and rename it over the entry, readers only ever see a complete entry
+    string path = cachePath(algo, params, fingerprint);
+    string temp = path + "." + to_string(hash<thread::id>()(this_thread::get_id())) + "_" + to_string(steady_clock::now().time_since_epoch().count()) + ".tmp";
+    {
+        ofstream file(temp, ios::binary);
+        file << contentsChecksum(contents) << " " << contents.size() << "\n" << contents;
+        file.flush();
+        if (!file)
+        {
+            file.close();
+            filesystem::remove(temp, ec);
+            return;
+        }
+    }
+    filesystem::rename(temp, path, ec);
+    if (ec)
+    {
+        filesystem::remove(temp, ec);
+    }
+}
+
+// one line per reached node: node distance predecessor weight, "-" marks the source's empty predecessor
+string serializeShortestPaths(const unordered_map<string, int> &shortest, const unordered_map<string, string> &predecessors, const unordered_map<string, int> &weights)
+{
+    ostringstream oss;
+    for (const auto &[node, distance] : shortest)
+    {
+        string pred = predecessors.count(node) > 0 && !predecessors.at(node).empty() ? predecessors.at(node) : "-";
+        int weight = weights.count(node) > 0 ? weights.at(node) : 0;
+        oss << node << " " << distance << " " << pred << " " << weight << "\n";
+    }
+    return oss.str();
+}
+
+void deserializeShortestPaths(const string &contents, unordered_map<string, int> &shortest, unordered_map<string, string> &predecessors, unordered_map<string, int> &weights)
+{
+    istringstream iss(contents);
+    string node, pred;
+    int distance, weight;
+    while (iss >> node >> distance >> pred >> weight)
+    {
+        shortest[node] = distance;
+        predecessors[node] = pred == "-" ? "" : pred;
+        if (pred != "-")
+        {
+            weights[node] = weight;
+        }
+    }
+}
+
+string serializeEdges(const vector<Edge> &edges)
+{
+    ostringstream oss;
+    for (const auto &edge : edges)
+    {
+        oss << edge.star1 << " " << edge.star2 << " " << edge.distance << "\n";
+    }
+    return oss.str();
+}
+
+vector<Edge> deserializeEdges(const string &contents)
+{
+    vector<Edge> edges;
+    istringstream iss(contents);
+    Edge edge;
+    while (iss >> edge.star1 >> edge.star2 >> edge.distance)
+    {
+        edges.push_back(edge);
+    }
+    return edges;
 }
 
 // Union-Find (Disjoint Set)
@@ -134,6 +556,26 @@ public:
     }
 };
 
+// per edge and total processing time, edge i of mst took processEdgeTime[i]
+void writeKruskalRecord(const vector<Edge> &mst, const vector<double> &processEdgeTime, double totalProcessingTimeMs)
+{
+    ofstream outputFile("Q3_krus_runtime_record.txt");
+    for (size_t i = 0; i < mst.size(); i++)
+    {
+        outputFile << "Edge " << mst[i].star1 << " - " << mst[i].star2 << " took: " << processEdgeTime[i] << " ms\n";
+    }
+    outputFile << "Total processing time: " << totalProcessingTimeMs << endl;
+
+    for (size_t i = 0; i < mst.size(); i++)
+    {
+        cout << "Edge " << mst[i].star1 << " - " << mst[i].star2 << " took: " << processEdgeTime[i] << " ms\n";
+    }
+
+    cout << endl;
+    cout << "Total processing time: " << totalProcessingTimeMs << endl;
+    cout << endl;
+}
+
 // Kruskal's algo
 vector<Edge> mst(const vector<Edge> &edges, const vector<string> &vertices)
 {
@@ -171,36 +613,33 @@ vector<Edge> mst(const vector<Edge> &edges, const vector<string> &vertices)
         totalProcessingTimeMs += duration.count();
     }
 
-    ofstream outputFile("Q3_krus_runtime_record.txt");
-    for (size_t i = 0; i < mst.size(); i++)
+    writeKruskalRecord(mst, processEdgeTime, totalProcessingTimeMs);
+    return mst;
+}
+
+// per node and total processing time, another record file for ploting
+void writeDijkstraRecord(const unordered_map<string, double> &processingTime, double totalProcessingTimeMs)
+{
+    ofstream outputFile("Q3_dijk_runtime_record.txt");
+    outputFile << "Processing time for each node:\n";
+    for (const auto &[node, time] : processingTime)
     {
-        outputFile << "Edge " << mst[i].star1 << " - " << mst[i].star2 << " took: " << processEdgeTime[i] << " ms\n";
+        outputFile << "Node " << node << " took: " << time << " ms\n";
     }
-    outputFile << "Total processing time: " << totalProcessingTimeMs << endl;
+    outputFile << "Total processing time: " << totalProcessingTimeMs << " ms\n";
 
-    for (size_t i = 0; i < mst.size(); i++)
+    cout << "Processing time for each node:\n";
+    for (const auto &[node, time] : processingTime)
     {
-        cout << "Edge " << mst[i].star1 << " - " << mst[i].star2 << " took: " << processEdgeTime[i] << " ms\n";
+        cout << "Node " << node << " took: " << time << " ms\n";
     }
-
-    cout << endl;
-    cout << "Total processing time: " << totalProcessingTimeMs << endl;
+    cout << "Total processing time: " << totalProcessingTimeMs << " ms\n";
     cout << endl;
-    return mst;
 }
 
-// Dijkstra shortest path
-unordered_map<string, int> shortestPath(const vector<Edge> &edges, const vector<string> &vertices, const string &src, unordered_map<string, string> &predecessors, unordered_map<string, int>& weights)
+// Dijkstra shortest path over an adjacency list that is already built
+unordered_map<string, int> shortestPath(unordered_map<string, vector<pair<string, int>>> &adj, const string &src, unordered_map<string, string> &predecessors, unordered_map<string, int> &weights)
 {
-    // initialize adjacency list
-    unordered_map<string, vector<pair<string, int>>> adj;
-
-    // populate the adjacency list with edges object
-    for (const auto &edge : edges)
-    {
-        adj[edge.star1].push_back(make_pair(edge.star2, edge.distance));
-    }
-
     // hashmap to store shortest distance
     unordered_map<string, int> shortest;
 
@@ -209,6 +648,9 @@ unordered_map<string, int> shortestPath(const vector<Edge> &edges, const vector<
 
     // begin with source code
     minHeap.push(make_pair(0, src));
+    // best distance pushed so far, a star's predecessor only changes when its distance improves
+    unordered_map<string, int> tentative;
+    tentative[src] = 0;
 
     // record time for processing
     unordered_map<string, double> processingTime;
@@ -236,9 +678,10 @@ unordered_map<string, int> shortestPath(const vector<Edge> &edges, const vector<
         // iterate over the adjacent nodes, neighboring stars
         for (const auto &[vertice_2, dis_2] : adj[vertice_1])
         {
-            // if adjacent node is not processed, add it to the minheap (prevent infinite loop between nodes with least edge value)
-            if (shortest.count(vertice_2) == 0)
+            // if adjacent node is not processed and this route is shorter, add it to the minheap (prevent infinite loop between nodes with least edge value)
+            if (shortest.count(vertice_2) == 0 && (tentative.count(vertice_2) == 0 || dis_1 + dis_2 < tentative[vertice_2]))
             {
+                tentative[vertice_2] = dis_1 + dis_2;
                 minHeap.push(make_pair(dis_1 + dis_2, vertice_2));
                 // store star into a vector
                 predecessors[vertice_2] = vertice_1;
@@ -253,23 +696,23 @@ unordered_map<string, int> shortestPath(const vector<Edge> &edges, const vector<
         totalProcessingTimeMs += durationMs;
     }
     // make another record time file for ploting
-    ofstream outputFile("Q3_dijk_runtime_record.txt");
-    outputFile << "Processing time for each node:\n";
-    for (const auto &[node, time] : processingTime)
-    {
-        outputFile << "Node " << node << " took: " << time << " ms\n";
-    }
-    outputFile << "Total processing time: " << totalProcessingTimeMs << " ms\n";
+    writeDijkstraRecord(processingTime, totalProcessingTimeMs);
 
-    cout << "Processing time for each node:\n";
-    for (const auto &[node, time] : processingTime)
+    return shortest;
+}
+
+unordered_map<string, int> shortestPath(const vector<Edge> &edges, const vector<string> &vertices, const string &src, unordered_map<string, string> &predecessors, unordered_map<string, int>& weights)
+{
+    // initialize adjacency list
+    unordered_map<string, vector<pair<string, int>>> adj;
+
+    // populate the adjacency list with edges object
+    for (const auto &edge : edges)
     {
-        cout << "Node " << node << " took: " << time << " ms\n";
+        adj[edge.star1].push_back(make_pair(edge.star2, edge.distance));
     }
-    cout << "Total processing time: " << totalProcessingTimeMs << " ms\n";
-    cout << endl;
 
-    return shortest;
+    return shortestPath(adj, src, predecessors, weights);
 }
 
 vector<pair<string, int>> reconstructPath(const unordered_map<string, string> &predecessors, const unordered_map<string, int>& weights, const string &target)
@@ -295,29 +738,1375 @@ vector<pair<string, int>> reconstructPath(const unordered_map<string, string> &p
     return path;
 }
 
-int main()
-{
-    int sortingChoice = 0;
-
-    vector<Star> stars;
-    vector<Edge> edges;
-    fileReader("Q1_dataset_2.txt", stars, edges);
+// Dense fast paths for small star maps
+// up to 64 stars fit a fixed size distance matrix with uint64_t visited sets, so Dijkstra and Prim run in O(V^2)
+// without string hashing or heap allocation, MaxV is fixed at compile time and picked by star count at runtime
+const int NO_ROUTE = INT_MAX;
 
-    cout << "1. Dijkstra's Algorithm (Shortest Path)" << endl;
-    cout << "2. Kruskals's Algorithm (Minimum Spanning Tree)" << endl;
-    cout << "3. Exit" << endl;
-    cout << "Enter Option: ";
-    cin >> sortingChoice;
+template <size_t MaxV>
+struct DenseGraph
+{
+    static_assert(MaxV <= 64, "visited sets are a single uint64_t");
+    int size = 0;
+    // directed like adj, NO_ROUTE where there is no route
+    array<array<int, MaxV>, MaxV> distance;
+    // shorter of the two directions, what the spanning tree uses
+    array<array<int, MaxV>, MaxV> undirected;
+};
 
-    if (sortingChoice != 1 && sortingChoice != 2)
+// false when a route names a star outside vertices, the generic solvers handle those
+template <size_t MaxV>
+bool buildDenseGraph(const vector<Edge> &edges, const vector<string> &vertices, DenseGraph<MaxV> &graph)
+{
+    graph.size = vertices.size();
+    for (auto &row : graph.distance)
     {
-        cout << "Invalid sorting algorithm, please try again." << endl;
-        return 1;
+        row.fill(NO_ROUTE);
     }
-
-    /*Code for verifying if vector is read*/
-    /*
-    cout << "List of Stars: " << endl;
+    for (auto &row : graph.undirected)
+    {
+        row.fill(NO_ROUTE);
+    }
+    auto indexOf = [&](const string &name)
+    {
+        for (int i = 0; i < graph.size; i++)
+        {
+            if (vertices[i] == name)
+            {
+                return i;
+            }
+        }
+        return -1;
+    };
+    for (const auto &edge : edges)
+    {
+        int u = indexOf(edge.star1), v = indexOf(edge.star2);
+        if (u == -1 || v == -1)
+        {
+            return false;
+        }
+        graph.distance[u][v] = min(graph.distance[u][v], edge.distance);
+        graph.undirected[u][v] = graph.undirected[v][u] = min(graph.undirected[u][v], edge.distance);
+    }
+    return true;
+}
+
+// per step times of one kernel run, only filled by the timed instantiation behind the runtime records
+template <size_t MaxV>
+struct DenseStepTimes
+{
+    array<double, MaxV> stepMs;
+    double totalMs = 0.0;
+};
+
+// Timed adds a clock read around every settled star for the record file, the solve itself runs untimed
+template <size_t MaxV, bool Timed = false>
+void denseDijkstra(const DenseGraph<MaxV> &graph, int src, array<int, MaxV> &shortest, array<int, MaxV> &parent, uint64_t &settled, DenseStepTimes<MaxV> *times = nullptr)
+{
+    shortest.fill(NO_ROUTE);
+    parent.fill(-1);
+    shortest[src] = 0;
+    settled = 0;
+    uint64_t frontier = 1ULL << src;
+    while (frontier != 0)
+    {
+        high_resolution_clock::time_point start_time;
+        if constexpr (Timed)
+        {
+            start_time = high_resolution_clock::now();
+        }
+        // closest star on the frontier
+        int u = -1;
+        for (uint64_t bits = frontier; bits != 0; bits &= bits - 1)
+        {
+            int v = __builtin_ctzll(bits);
+            if (u == -1 || shortest[v] < shortest[u])
+            {
+                u = v;
+            }
+        }
+        frontier &= ~(1ULL << u);
+        settled |= 1ULL << u;
+
+        for (int v = 0; v < graph.size; v++)
+        {
+            int d = graph.distance[u][v];
+            if (d != NO_ROUTE && ((settled >> v) & 1) == 0 && shortest[u] + d < shortest[v])
+            {
+                shortest[v] = shortest[u] + d;
+                parent[v] = u;
+                frontier |= 1ULL << v;
+            }
+        }
+        if constexpr (Timed)
+        {
+            times->stepMs[u] = msSince(start_time);
+            times->totalMs += times->stepMs[u];
+        }
+    }
+}
+
+// routes are undirected for the spanning tree, stars the routes do not reach start a new tree like Kruskal's forest
+// returns the number of tree edges, edge i joins from[i] and to[i], Timed records the step that added each edge
+template <size_t MaxV, bool Timed = false>
+int densePrim(const DenseGraph<MaxV> &graph, array<int, MaxV> &from, array<int, MaxV> &to, array<int, MaxV> &length, DenseStepTimes<MaxV> *times = nullptr)
+{
+    array<int, MaxV> best, link;
+    best.fill(NO_ROUTE);
+    link.fill(-1);
+    uint64_t all = graph.size == 64 ? ~0ULL : (1ULL << graph.size) - 1;
+    uint64_t inTree = 0;
+    int count = 0;
+    while (inTree != all)
+    {
+        high_resolution_clock::time_point start_time;
+        if constexpr (Timed)
+        {
+            start_time = high_resolution_clock::now();
+        }
+        int u = -1;
+        for (uint64_t bits = all & ~inTree; bits != 0; bits &= bits - 1)
+        {
+            int v = __builtin_ctzll(bits);
+            if (u == -1 || best[v] < best[u])
+            {
+                u = v;
+            }
+        }
+        inTree |= 1ULL << u;
+        bool added = link[u] != -1;
+        if (added)
+        {
+            from[count] = link[u];
+            to[count] = u;
+            length[count] = best[u];
+            count++;
+        }
+
+        for (uint64_t bits = all & ~inTree; bits != 0; bits &= bits - 1)
+        {
+            int v = __builtin_ctzll(bits);
+            int d = graph.undirected[u][v];
+            if (d < best[v])
+            {
+                best[v] = d;
+                link[v] = u;
+            }
+        }
+        if constexpr (Timed)
+        {
+            double stepMs = msSince(start_time);
+            if (added)
+            {
+                times->stepMs[count - 1] = stepMs;
+            }
+            times->totalMs += stepMs;
+        }
+    }
+    return count;
+}
+
+// tree edges with a route in ascending distance, the order mst reports its edges in
+template <size_t MaxV>
+vector<int> denseTreeOrder(int count, const array<int, MaxV> &length)
+{
+    vector<int> order;
+    for (int i = 0; i < count; i++)
+    {
+        if (length[i] != NO_ROUTE)
+        {
+            order.push_back(i);
+        }
+    }
+    stable_sort(order.begin(), order.end(), [&](int a, int b)
+                { return length[a] < length[b]; });
+    return order;
+}
+
+template <size_t MaxV>
+bool solveDenseShortestPath(const vector<Edge> &edges, const vector<string> &vertices, const string &src, unordered_map<string, int> &result, unordered_map<string, string> &predecessors, unordered_map<string, int> &weights)
+{
+    DenseGraph<MaxV> graph;
+    auto it = find(vertices.begin(), vertices.end(), src);
+    if (it == vertices.end() || !buildDenseGraph(edges, vertices, graph))
+    {
+        return false;
+    }
+    int source = it - vertices.begin();
+    array<int, MaxV> shortest, parent;
+    uint64_t settled = 0;
+    denseDijkstra(graph, source, shortest, parent, settled);
+
+    // back to the maps the rest of the program prints from
+    for (int v = 0; v < graph.size; v++)
+    {
+        if ((settled >> v) & 1)
+        {
+            result[vertices[v]] = shortest[v];
+            if (parent[v] != -1)
+            {
+                predecessors[vertices[v]] = vertices[parent[v]];
+                weights[vertices[v]] = graph.distance[parent[v]][v];
+            }
+        }
+    }
+    return true;
+}
+
+template <size_t MaxV>
+bool solveDenseMst(const vector<Edge> &edges, const vector<string> &vertices, vector<Edge> &mstEdges)
+{
+    DenseGraph<MaxV> graph;
+    if (!buildDenseGraph(edges, vertices, graph))
+    {
+        return false;
+    }
+    array<int, MaxV> from, to, length;
+    int count = densePrim(graph, from, to, length);
+    for (int i : denseTreeOrder<MaxV>(count, length))
+    {
+        mstEdges.push_back(Edge{vertices[min(from[i], to[i])], vertices[max(from[i], to[i])], length[i]});
+    }
+    return true;
+}
+
+// a second, timed run that writes Q3_dijk_runtime_record.txt in the per node format of shortestPath
+template <size_t MaxV>
+void recordDenseShortestPath(const vector<Edge> &edges, const vector<string> &vertices, const string &src)
+{
+    DenseGraph<MaxV> graph;
+    auto it = find(vertices.begin(), vertices.end(), src);
+    if (it == vertices.end() || !buildDenseGraph(edges, vertices, graph))
+    {
+        return;
+    }
+    array<int, MaxV> shortest, parent;
+    uint64_t settled = 0;
+    DenseStepTimes<MaxV> times;
+    denseDijkstra<MaxV, true>(graph, it - vertices.begin(), shortest, parent, settled, &times);
+
+    unordered_map<string, double> processingTime;
+    for (int v = 0; v < graph.size; v++)
+    {
+        if ((settled >> v) & 1)
+        {
+            processingTime[vertices[v]] = times.stepMs[v];
+        }
+    }
+    writeDijkstraRecord(processingTime, times.totalMs);
+}
+
+// a second, timed run that writes Q3_krus_runtime_record.txt in the per edge format of mst
+template <size_t MaxV>
+void recordDenseMst(const vector<Edge> &edges, const vector<string> &vertices)
+{
+    DenseGraph<MaxV> graph;
+    if (!buildDenseGraph(edges, vertices, graph))
+    {
+        return;
+    }
+    array<int, MaxV> from, to, length;
+    DenseStepTimes<MaxV> times;
+    int count = densePrim<MaxV, true>(graph, from, to, length, &times);
+
+    vector<Edge> tree;
+    vector<double> processEdgeTime;
+    for (int i : denseTreeOrder<MaxV>(count, length))
+    {
+        tree.push_back(Edge{vertices[min(from[i], to[i])], vertices[max(from[i], to[i])], length[i]});
+        processEdgeTime.push_back(times.stepMs[i]);
+    }
+    writeKruskalRecord(tree, processEdgeTime, times.totalMs);
+}
+
+// runtime dispatch by star count, false means the graph is too big and the generic solver has to run
+bool denseShortestPath(const vector<Edge> &edges, const vector<string> &vertices, const string &src, unordered_map<string, int> &result, unordered_map<string, string> &predecessors, unordered_map<string, int> &weights)
+{
+    if (vertices.size() <= 32)
+    {
+        return solveDenseShortestPath<32>(edges, vertices, src, result, predecessors, weights);
+    }
+    if (vertices.size() <= 64)
+    {
+        return solveDenseShortestPath<64>(edges, vertices, src, result, predecessors, weights);
+    }
+    return false;
+}
+
+bool denseMst(const vector<Edge> &edges, const vector<string> &vertices, vector<Edge> &mstEdges)
+{
+    if (vertices.size() <= 32)
+    {
+        return solveDenseMst<32>(edges, vertices, mstEdges);
+    }
+    if (vertices.size() <= 64)
+    {
+        return solveDenseMst<64>(edges, vertices, mstEdges);
+    }
+    return false;
+}
+
+// the record runs are kept out of the reported solve and program runtimes
+void denseShortestPathRecord(const vector<Edge> &edges, const vector<string> &vertices, const string &src)
+{
+    if (vertices.size() <= 32)
+    {
+        recordDenseShortestPath<32>(edges, vertices, src);
+    }
+    else if (vertices.size() <= 64)
+    {
+        recordDenseShortestPath<64>(edges, vertices, src);
+    }
+}
+
+void denseMstRecord(const vector<Edge> &edges, const vector<string> &vertices)
+{
+    if (vertices.size() <= 32)
+    {
+        recordDenseMst<32>(edges, vertices);
+    }
+    else if (vertices.size() <= 64)
+    {
+        recordDenseMst<64>(edges, vertices);
+    }
+}
+
+// K shortest loopless paths (Yen's algorithm)
+struct WeightedPath
+{
+    int distance;
+    // Star(weight) pairs in the same form as reconstructPath
+    vector<pair<string, int>> stars;
+};
+
+// distance from every star to target, Dijkstra over the reversed routes
+unordered_map<string, int> distancesToTarget(const unordered_map<string, vector<pair<string, int>>> &adj, const string &target)
+{
+    unordered_map<string, vector<pair<string, int>>> reverseAdj;
+    for (const auto &[from, neighbours] : adj)
+    {
+        for (const auto &[to, distance] : neighbours)
+        {
+            reverseAdj[to].push_back(make_pair(from, distance));
+        }
+    }
+
+    unordered_map<string, int> toTarget;
+    priority_queue<pair<int, string>, vector<pair<int, string>>, greater<pair<int, string>>> minHeap;
+    minHeap.push(make_pair(0, target));
+    while (!minHeap.empty())
+    {
+        auto [dis_1, vertice_1] = minHeap.top();
+        minHeap.pop();
+        if (toTarget.count(vertice_1) > 0)
+        {
+            continue;
+        }
+        toTarget[vertice_1] = dis_1;
+        for (const auto &[vertice_2, dis_2] : reverseAdj[vertice_1])
+        {
+            if (toTarget.count(vertice_2) == 0)
+            {
+                minHeap.push(make_pair(dis_1 + dis_2, vertice_2));
+            }
+        }
+    }
+    return toTarget;
+}
+
+// A* from spur to target that avoids blocked stars and routes
+// toTarget is exact on the full graph, so it stays a consistent lower bound once stars and routes are removed
+bool spurSearch(const unordered_map<string, vector<pair<string, int>>> &adj, const unordered_map<string, int> &toTarget, const string &spur, const string &target,
+                const unordered_set<string> &blockedStars, const set<tuple<string, string, int>> &blockedRoutes, WeightedPath &result)
+{
+    unordered_map<string, int> best;
+    unordered_map<string, pair<string, int>> predecessors;
+    // estimated total, distance so far, star
+    priority_queue<tuple<int, int, string>, vector<tuple<int, int, string>>, greater<tuple<int, int, string>>> open;
+    best[spur] = 0;
+    open.push(make_tuple(toTarget.at(spur), 0, spur));
+
+    while (!open.empty())
+    {
+        auto [estimate, dis_1, vertice_1] = open.top();
+        open.pop();
+        if (dis_1 > best[vertice_1])
+        {
+            continue;
+        }
+        if (vertice_1 == target)
+        {
+            // backtrack to the spur star
+            result.distance = dis_1;
+            result.stars.clear();
+            for (string at = target; at != spur; at = predecessors[at].first)
+            {
+                result.stars.push_back(make_pair(at, predecessors[at].second));
+            }
+            result.stars.push_back(make_pair(spur, 0));
+            reverse(result.stars.begin(), result.stars.end());
+            return true;
+        }
+
+        auto it = adj.find(vertice_1);
+        if (it == adj.end())
+        {
+            continue;
+        }
+        for (const auto &[vertice_2, dis_2] : it->second)
+        {
+            auto h = toTarget.find(vertice_2);
+            // stars that cannot reach the target are never worth expanding
+            if (h == toTarget.end() || blockedStars.count(vertice_2) > 0 || blockedRoutes.count(make_tuple(vertice_1, vertice_2, dis_2)) > 0)
+            {
+                continue;
+            }
+            int distance = dis_1 + dis_2;
+            auto known = best.find(vertice_2);
+            if (known == best.end() || distance < known->second)
+            {
+                best[vertice_2] = distance;
+                predecessors[vertice_2] = make_pair(vertice_1, dis_2);
+                open.push(make_tuple(distance + h->second, distance, vertice_2));
+            }
+        }
+    }
+    return false;
+}
+
+vector<WeightedPath> kShortestPaths(const unordered_map<string, vector<pair<string, int>>> &adj, const string &src, const string &target, size_t k)
+{
+    vector<WeightedPath> found;
+    // reverse shortest path tree, shared by every spur search as its lower bound
+    unordered_map<string, int> toTarget = distancesToTarget(adj, target);
+    if (k == 0 || toTarget.count(src) == 0)
+    {
+        return found;
+    }
+
+    WeightedPath first;
+    spurSearch(adj, toTarget, src, target, {}, {}, first);
+    found.push_back(first);
+
+    // ordered by distance, the set also drops a candidate found from two different spurs
+    set<pair<int, vector<pair<string, int>>>> candidates;
+    const size_t workers = max(1u, thread::hardware_concurrency());
+
+    while (found.size() < k)
+    {
+        const vector<pair<string, int>> last = found.back().stars;
+
+        // a spur whose lower bound is above the (k - found)th candidate can never make the top k
+        size_t needed = k - found.size();
+        int bound = INT_MAX;
+        if (candidates.size() >= needed)
+        {
+            bound = next(candidates.begin(), needed - 1)->first;
+        }
+
+        vector<future<pair<bool, WeightedPath>>> spurs;
+        auto collect = [&]()
+        {
+            for (auto &spur : spurs)
+            {
+                auto [ok, path] = spur.get();
+                if (ok)
+                {
+                    candidates.insert(make_pair(path.distance, path.stars));
+                }
+            }
+            spurs.clear();
+        };
+
+        int rootDistance = 0;
+        for (size_t i = 0; i + 1 < last.size(); i++)
+        {
+            rootDistance += last[i].second;
+            const string &spur = last[i].first;
+            if (rootDistance + toTarget.at(spur) > bound)
+            {
+                continue;
+            }
+
+            // routes leaving the spur that an already found path with the same root takes
+            set<tuple<string, string, int>> blockedRoutes;
+            for (const auto &path : found)
+            {
+                if (path.stars.size() > i + 1 && equal(last.begin(), last.begin() + i + 1, path.stars.begin()))
+                {
+                    blockedRoutes.insert(make_tuple(path.stars[i].first, path.stars[i + 1].first, path.stars[i + 1].second));
+                }
+            }
+            // root stars other than the spur keep the path loopless
+            unordered_set<string> blockedStars;
+            for (size_t j = 0; j < i; j++)
+            {
+                blockedStars.insert(last[j].first);
+            }
+
+            vector<pair<string, int>> root(last.begin(), last.begin() + i);
+            int spurWeight = last[i].second;
+            spurs.push_back(async(launch::async, [&adj, &toTarget, &target, spur, spurWeight, root, rootDistance, blockedStars, blockedRoutes]()
+                                  {
+                WeightedPath spurPath;
+                if (!spurSearch(adj, toTarget, spur, target, blockedStars, blockedRoutes, spurPath))
+                {
+                    return make_pair(false, spurPath);
+                }
+                // spur star keeps the weight of the route that reached it in the root
+                spurPath.stars[0].second = spurWeight;
+                WeightedPath total;
+                total.distance = rootDistance + spurPath.distance;
+                total.stars = root;
+                total.stars.insert(total.stars.end(), spurPath.stars.begin(), spurPath.stars.end());
+                return make_pair(true, total); }));
+
+            if (spurs.size() == workers)
+            {
+                collect();
+            }
+        }
+        collect();
+
+        if (candidates.empty())
+        {
+            break;
+        }
+        WeightedPath next;
+        next.distance = candidates.begin()->first;
+        next.stars = candidates.begin()->second;
+        candidates.erase(candidates.begin());
+        found.push_back(next);
+    }
+    return found;
+}
+
+// Euclidean minimum spanning tree
+// Boruvka rounds over a k-d tree of the star coordinates, each round only asks for every star's
+// nearest star in another component, so the complete graph of routes is never built
+
+// same truncation as calculateDistance in Q1_data2.cpp
+int truncatedDistance(long long squared)
+{
+    return static_cast<int>(sqrt(static_cast<double>(squared)));
+}
+
+// edges are ordered by truncated distance like mst, equal distances by star index so every round agrees on one order
+bool edgeLess(int d1, int a1, int b1, int d2, int a2, int b2)
+{
+    return make_tuple(d1, min(a1, b1), max(a1, b1)) < make_tuple(d2, min(a2, b2), max(a2, b2));
+}
+
+// Union-Find over star indices, same ranks and path compression as UnionFind
+class IndexUnionFind
+{
+public:
+    vector<int> parent;
+    vector<int> rank;
+
+    IndexUnionFind(int n) : parent(n), rank(n, 0)
+    {
+        iota(parent.begin(), parent.end(), 0);
+    }
+
+    int find(int n)
+    {
+        while (parent[n] != n)
+        {
+            parent[n] = parent[parent[n]];
+            n = parent[n];
+        }
+        return n;
+    }
+
+    bool uni0n(int n1, int n2)
+    {
+        int p1 = find(n1), p2 = find(n2);
+        if (p1 == p2)
+        {
+            return false;
+        }
+        if (rank[p1] > rank[p2])
+        {
+            parent[p2] = p1;
+        }
+        else if (rank[p1] < rank[p2])
+        {
+            parent[p1] = p2;
+        }
+        else
+        {
+            parent[p1] = p2;
+            rank[p2] += 1;
+        }
+        return true;
+    }
+};
+
+class KdTree
+{
+public:
+    KdTree(const vector<Star> &stars) : points(stars.size()), order(stars.size())
+    {
+        for (size_t i = 0; i < stars.size(); i++)
+        {
+            points[i] = {stars[i].x, stars[i].y, stars[i].z};
+        }
+        iota(order.begin(), order.end(), 0);
+        nodes.reserve(2 * stars.size() / LEAF_SIZE + 2);
+        build(0, stars.size(), 0);
+
+        // store the coordinates in tree order so a leaf's stars sit next to each other in memory
+        vector<array<int, 3>> sorted(stars.size());
+        for (size_t i = 0; i < stars.size(); i++)
+        {
+            sorted[i] = points[order[i]];
+        }
+        points.swap(sorted);
+    }
+
+    // stars are indexed by their position in the tree, position i holds stars[original(i)]
+    int original(int i) const
+    {
+        return order[i];
+    }
+
+    // mark every node whose stars all belong to one component, those nodes are skipped by that component's queries
+    void labelComponents(const vector<int> &component)
+    {
+        label(0, component);
+    }
+
+    // nearest star to p that is in another component and no further than bound, bestIndex is -1 if there is none
+    void nearestOther(int p, const vector<int> &component, int bound, int &bestIndex, int &bestDistance) const
+    {
+        Query query = {p, -1, bound, (bound + 1LL) * (bound + 1LL)};
+        search(0, query, component);
+        bestIndex = query.bestIndex;
+        bestDistance = query.bestDistance;
+    }
+
+private:
+    static const int LEAF_SIZE = 16;
+
+    struct KdNode
+    {
+        array<int, 3> minCorner, maxCorner;
+        // range of tree positions under this node
+        int start, end;
+        int left = -1, right = -1;
+        // component shared by every star under this node, -1 when mixed
+        int component = -1;
+    };
+
+    int build(int start, int end, int depth)
+    {
+        int index = nodes.size();
+        nodes.push_back(KdNode());
+        KdNode node;
+        node.start = start;
+        node.end = end;
+        node.minCorner = node.maxCorner = points[order[start]];
+        for (int i = start; i < end; i++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                node.minCorner[axis] = min(node.minCorner[axis], points[order[i]][axis]);
+                node.maxCorner[axis] = max(node.maxCorner[axis], points[order[i]][axis]);
+            }
+        }
+        if (end - start > LEAF_SIZE)
+        {
+            // split on the widest axis at the median
+            int axis = 0;
+            for (int a = 1; a < 3; a++)
+            {
+                if ((long long)node.maxCorner[a] - (long long)node.minCorner[a] > (long long)node.maxCorner[axis] - (long long)node.minCorner[axis])
+                {
+                    axis = a;
+                }
+            }
+            int mid = start + (end - start) / 2;
+            nth_element(order.begin() + start, order.begin() + mid, order.begin() + end, [&](int a, int b)
+                        { return points[a][axis] < points[b][axis]; });
+            node.left = build(start, mid, depth + 1);
+            node.right = build(mid, end, depth + 1);
+        }
+        nodes[index] = node;
+        return index;
+    }
+
+    int label(int index, const vector<int> &component)
+    {
+        KdNode &node = nodes[index];
+        if (node.left == -1)
+        {
+            node.component = component[node.start];
+            for (int i = node.start + 1; i < node.end; i++)
+            {
+                if (component[i] != node.component)
+                {
+                    node.component = -1;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            int left = label(node.left, component);
+            int right = label(node.right, component);
+            node.component = left == right ? left : -1;
+        }
+        return node.component;
+    }
+
+    long long squaredDistanceToBox(int p, const KdNode &node) const
+    {
+        long long total = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            long long gap = 0;
+            if (points[p][axis] < node.minCorner[axis])
+            {
+                gap = (long long)node.minCorner[axis] - (long long)points[p][axis];
+            }
+            else if (points[p][axis] > node.maxCorner[axis])
+            {
+                gap = (long long)points[p][axis] - (long long)node.maxCorner[axis];
+            }
+            total += gap * gap;
+        }
+        return total;
+    }
+
+    struct Query
+    {
+        int p;
+        int bestIndex;
+        int bestDistance;
+        // squared distance at which the truncated distance first exceeds bestDistance
+        long long limit;
+    };
+
+    void search(int index, Query &query, const vector<int> &component) const
+    {
+        const KdNode &node = nodes[index];
+        // truncation keeps order, so a box whose truncated lower bound is above the best cannot hold anything better
+        // equal bounds are still searched because a lower star index wins the tie
+        if (node.component == component[query.p] || squaredDistanceToBox(query.p, node) >= query.limit)
+        {
+            return;
+        }
+        if (node.left == -1)
+        {
+            const array<int, 3> &from = points[query.p];
+            for (int q = node.start; q < node.end; q++)
+            {
+                long long dx = (long long)from[0] - (long long)points[q][0], dy = (long long)from[1] - (long long)points[q][1], dz = (long long)from[2] - (long long)points[q][2];
+                long long squared = dx * dx + dy * dy + dz * dz;
+                if (squared >= query.limit || component[q] == component[query.p])
+                {
+                    continue;
+                }
+                int distance = truncatedDistance(squared);
+                if (query.bestIndex == -1 ? distance <= query.bestDistance : edgeLess(distance, order[query.p], order[q], query.bestDistance, order[query.p], order[query.bestIndex]))
+                {
+                    query.bestIndex = q;
+                    query.bestDistance = distance;
+                    query.limit = (distance + 1LL) * (distance + 1LL);
+                }
+            }
+            return;
+        }
+        // closer child first so the bound tightens early
+        int first = node.left, second = node.right;
+        if (squaredDistanceToBox(query.p, nodes[second]) < squaredDistanceToBox(query.p, nodes[first]))
+        {
+            swap(first, second);
+        }
+        search(first, query, component);
+        search(second, query, component);
+    }
+
+    vector<array<int, 3>> points;
+    vector<int> order;
+    vector<KdNode> nodes;
+};
+
+// widest coordinate range per axis whose longest distance, sqrt(3) times the range, still fits an int Edge distance,
+// which also keeps every squared distance well inside long long
+const long long MAX_COORDINATE_SPAN = 1239850262;
+
+bool coordinatesInRange(const vector<Star> &stars)
+{
+    if (stars.empty())
+    {
+        return true;
+    }
+    long long low[3] = {stars[0].x, stars[0].y, stars[0].z}, high[3] = {stars[0].x, stars[0].y, stars[0].z};
+    for (const auto &star : stars)
+    {
+        long long point[3] = {star.x, star.y, star.z};
+        for (int axis = 0; axis < 3; axis++)
+        {
+            low[axis] = min(low[axis], point[axis]);
+            high[axis] = max(high[axis], point[axis]);
+        }
+    }
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (high[axis] - low[axis] > MAX_COORDINATE_SPAN)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// stars must pass coordinatesInRange
+vector<Edge> euclideanMst(const vector<Star> &stars)
+{
+    int n = stars.size();
+    vector<Edge> mst;
+    if (n < 2)
+    {
+        return mst;
+    }
+
+    KdTree tree(stars);
+    IndexUnionFind unionFind(n);
+    // indexed by tree position, see KdTree::original
+    vector<int> component(n);
+    iota(component.begin(), component.end(), 0);
+    // distance, star index, star index
+    vector<tuple<int, int, int>> chosen;
+    const int workers = max(1u, thread::hardware_concurrency());
+
+    vector<int> nearest(n, -1), nearestDistance(n, INT_MAX);
+    while ((int)chosen.size() < n - 1)
+    {
+        tree.labelComponents(component);
+
+        // a star's nearest star in another component stays its nearest until the two merge, merging only removes
+        // candidates, so only stars whose nearest joined their component are queried again
+        vector<atomic<int>> bound(n);
+        vector<int> stale;
+        for (int p = 0; p < n; p++)
+        {
+            bound[p] = INT_MAX;
+        }
+        for (int p = 0; p < n; p++)
+        {
+            if (nearest[p] != -1 && component[nearest[p]] != component[p])
+            {
+                bound[component[p]] = min(bound[component[p]].load(), nearestDistance[p]);
+            }
+        }
+        for (int p = 0; p < n; p++)
+        {
+            bool valid = nearest[p] != -1 && component[nearest[p]] != component[p];
+            // a star whose last bounded query found nothing is known to be further than that bound,
+            // it only needs asking again once its component's bound reaches that far
+            bool beyondBound = nearest[p] == -1 && nearestDistance[p] > bound[component[p]];
+            if (!valid && !beyondBound)
+            {
+                stale.push_back(p);
+            }
+        }
+
+        // each query is bounded by the best edge its component has so far, split across threads
+        vector<thread> threads;
+        for (int w = 0; w < workers; w++)
+        {
+            threads.emplace_back([&, w]()
+                                 {
+                for (size_t i = w; i < stale.size(); i += workers)
+                {
+                    int p = stale[i];
+                    atomic<int> &componentBound = bound[component[p]];
+                    int limit = componentBound.load();
+                    tree.nearestOther(p, component, limit, nearest[p], nearestDistance[p]);
+                    if (nearest[p] == -1)
+                    {
+                        // remember that nothing is within limit, so next time its lower bound is limit + 1
+                        nearestDistance[p] = limit == INT_MAX ? INT_MAX : limit + 1;
+                        continue;
+                    }
+                    int current = componentBound.load();
+                    while (nearestDistance[p] < current && !componentBound.compare_exchange_weak(current, nearestDistance[p]))
+                    {
+                    }
+                } });
+        }
+        for (auto &t : threads)
+        {
+            t.join();
+        }
+
+        // cheapest edge leaving each component
+        vector<int> cheapest(n, -1);
+        for (int p = 0; p < n; p++)
+        {
+            int c = component[p];
+            int best = cheapest[c];
+            if (nearest[p] == -1)
+            {
+                continue;
+            }
+            if (best == -1 || edgeLess(nearestDistance[p], tree.original(p), tree.original(nearest[p]), nearestDistance[best], tree.original(best), tree.original(nearest[best])))
+            {
+                cheapest[c] = p;
+            }
+        }
+
+        // two components picking the same edge is caught by the union find
+        for (int c = 0; c < n; c++)
+        {
+            int p = cheapest[c];
+            if (p != -1 && unionFind.uni0n(p, nearest[p]))
+            {
+                int a = tree.original(p), b = tree.original(nearest[p]);
+                chosen.push_back(make_tuple(nearestDistance[p], min(a, b), max(a, b)));
+            }
+        }
+        for (int p = 0; p < n; p++)
+        {
+            component[p] = unionFind.find(p);
+        }
+    }
+
+    // ascending distance, the order mst reports its edges in
+    sort(chosen.begin(), chosen.end());
+    for (const auto &[distance, a, b] : chosen)
+    {
+        // "Star A" -> "A", the names the routes use
+        string star1 = stars[a].name.substr(stars[a].name.find_last_of(' ') + 1);
+        string star2 = stars[b].name.substr(stars[b].name.find_last_of(' ') + 1);
+        mst.push_back(Edge{star1, star2, distance});
+    }
+    return mst;
+}
+
+// one path per line: distance then star weight pairs
+string serializePaths(const vector<WeightedPath> &paths)
+{
+    ostringstream oss;
+    for (const auto &path : paths)
+    {
+        oss << path.distance;
+        for (const auto &[p, w] : path.stars)
+        {
+            oss << " " << p << " " << w;
+        }
+        oss << "\n";
+    }
+    return oss.str();
+}
+
+vector<WeightedPath> deserializePaths(const string &contents)
+{
+    vector<WeightedPath> paths;
+    istringstream lines(contents);
+    string line;
+    while (getline(lines, line))
+    {
+        istringstream iss(line);
+        WeightedPath path;
+        string p;
+        int w;
+        iss >> path.distance;
+        while (iss >> p >> w)
+        {
+            path.stars.push_back(make_pair(p, w));
+        }
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+// LEB128 style, 7 bits per byte with the high bit set on every byte but the last
+void writeVarint(vector<uint8_t> &bytes, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        bytes.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    bytes.push_back(uint8_t(value));
+}
+
+uint32_t readVarint(const uint8_t *&bytes)
+{
+    uint32_t value = 0;
+    int shift = 0;
+    uint8_t byte;
+    do
+    {
+        byte = *bytes++;
+        value |= uint32_t(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return value;
+}
+
+// Compressed star graph
+// stars are numbered by sorted name, each star's outgoing routes are sorted by target and stored as
+// varint encoded gaps, distances are packed into the narrowest of 1, 2 or 4 bytes that holds the largest one
+class CompressedGraph
+{
+public:
+    // walks one star's routes, decoding each target and distance only when it is reached
+    class NeighbourIterator
+    {
+    public:
+        NeighbourIterator(const CompressedGraph &graph, int star)
+            : graph(graph), bytes(graph.targets.data() + graph.targetOffset[star]), route(graph.firstRoute[star]), lastRoute(graph.firstRoute[star + 1]) {}
+
+        bool next(int &target, int &distance)
+        {
+            if (route == lastRoute)
+            {
+                return false;
+            }
+            current += readVarint(bytes);
+            target = current;
+            distance = graph.weightAt(route);
+            route++;
+            return true;
+        }
+
+    private:
+        const CompressedGraph &graph;
+        const uint8_t *bytes;
+        uint64_t route, lastRoute;
+        int current = 0;
+    };
+
+    NeighbourIterator neighbours(int star) const
+    {
+        return NeighbourIterator(*this, star);
+    }
+
+    int starCount() const
+    {
+        return names.size();
+    }
+
+    uint64_t routeCount() const
+    {
+        return firstRoute.empty() ? 0 : firstRoute.back();
+    }
+
+    const string &name(int star) const
+    {
+        return names[star];
+    }
+
+    // -1 when the star has no routes
+    int indexOf(const string &star) const
+    {
+        auto it = lower_bound(names.begin(), names.end(), star);
+        return it != names.end() && *it == star ? int(it - names.begin()) : -1;
+    }
+
+    int weightWidth() const
+    {
+        return weightBytes;
+    }
+
+    size_t bytes() const
+    {
+        size_t total = targets.capacity() + weights.capacity() + (firstRoute.capacity() + targetOffset.capacity()) * sizeof(uint64_t);
+        for (const auto &star : names)
+        {
+            total += sizeof(string) + (star.size() > 15 ? star.capacity() + 1 : 0);
+        }
+        return total;
+    }
+
+private:
+    friend class CompressedGraphBuilder;
+
+    int weightAt(uint64_t route) const
+    {
+        const uint8_t *w = weights.data() + route * weightBytes;
+        switch (weightBytes)
+        {
+        case 1:
+            return w[0];
+        case 2:
+            return w[0] | (w[1] << 8);
+        default:
+            uint32_t distance;
+            memcpy(&distance, w, 4);
+            return distance;
+        }
+    }
+
+    vector<string> names;
+    // star u's routes are route numbers [firstRoute[u], firstRoute[u + 1]), its targets start at targets[targetOffset[u]]
+    vector<uint64_t> firstRoute;
+    vector<uint64_t> targetOffset;
+    vector<uint8_t> targets;
+    vector<uint8_t> weights;
+    int weightBytes = 1;
+};
+
+// builds a CompressedGraph from route chunks as they are parsed, so the Edge list never exists
+// each source star collects its routes as varint target and distance in arrival order, finish sorts
+// one star at a time into the gap encoded layout and frees that star's bucket before the next
+class CompressedGraphBuilder
+{
+public:
+    // distances are truncated euclidean lengths, so never negative
+    void add(const vector<Edge> &chunk)
+    {
+        for (const auto &edge : chunk)
+        {
+            int from = intern(edge.star1), to = intern(edge.star2);
+            writeVarint(pending[from], to);
+            writeVarint(pending[from], edge.distance);
+            maxDistance = max(maxDistance, edge.distance);
+            routes++;
+        }
+    }
+
+    CompressedGraph finish()
+    {
+        // stars are numbered by sorted name, rank maps an arrival id to that number
+        int n = names.size();
+        vector<int> order(n), rank(n);
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [&](int a, int b)
+             { return names[a] < names[b]; });
+        for (int i = 0; i < n; i++)
+        {
+            rank[order[i]] = i;
+        }
+
+        CompressedGraph graph;
+        graph.weightBytes = maxDistance <= 0xFF ? 1 : maxDistance <= 0xFFFF ? 2 : 4;
+        graph.weights.resize(routes * graph.weightBytes);
+        graph.firstRoute.assign(n + 1, 0);
+        graph.targetOffset.assign(n + 1, 0);
+        vector<pair<int, int>> starRoutes;
+        uint64_t r = 0;
+        for (int u = 0; u < n; u++)
+        {
+            vector<uint8_t> &bucket = pending[order[u]];
+            starRoutes.clear();
+            for (const uint8_t *bytes = bucket.data(); bytes != bucket.data() + bucket.size();)
+            {
+                int to = rank[readVarint(bytes)];
+                int distance = readVarint(bytes);
+                starRoutes.push_back(make_pair(to, distance));
+            }
+            vector<uint8_t>().swap(bucket);
+            sort(starRoutes.begin(), starRoutes.end());
+
+            graph.firstRoute[u] = r;
+            graph.targetOffset[u] = graph.targets.size();
+            int previous = 0;
+            for (const auto &[to, distance] : starRoutes)
+            {
+                writeVarint(graph.targets, to - previous);
+                previous = to;
+                // little endian low bytes, read back the same way in weightAt
+                for (int b = 0; b < graph.weightBytes; b++)
+                {
+                    graph.weights[r * graph.weightBytes + b] = (uint32_t(distance) >> (8 * b)) & 0xFF;
+                }
+                r++;
+            }
+        }
+        graph.firstRoute[n] = r;
+        graph.targetOffset[n] = graph.targets.size();
+        graph.targets.shrink_to_fit();
+        for (int id : order)
+        {
+            graph.names.push_back(move(names[id]));
+        }
+        ids.clear();
+        names.clear();
+        pending.clear();
+        return graph;
+    }
+
+private:
+    int intern(const string &name)
+    {
+        auto [it, inserted] = ids.emplace(name, names.size());
+        if (inserted)
+        {
+            names.push_back(name);
+            pending.emplace_back();
+        }
+        return it->second;
+    }
+
+    // names are interned once per star, not once per route
+    unordered_map<string, int> ids;
+    vector<string> names;
+    vector<vector<uint8_t>> pending;
+    uint64_t routes = 0;
+    int maxDistance = 0;
+};
+
+// Dijkstra straight over the compressed routes, stars are indices so no name is hashed
+void compressedShortestPath(const CompressedGraph &graph, int src, vector<int> &shortest, vector<int> &parent)
+{
+    shortest.assign(graph.starCount(), NO_ROUTE);
+    parent.assign(graph.starCount(), -1);
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> minHeap;
+    shortest[src] = 0;
+    minHeap.push(make_pair(0, src));
+    while (!minHeap.empty())
+    {
+        auto [dis_1, vertice_1] = minHeap.top();
+        minHeap.pop();
+        if (dis_1 > shortest[vertice_1])
+        {
+            continue;
+        }
+        auto it = graph.neighbours(vertice_1);
+        int vertice_2, dis_2;
+        while (it.next(vertice_2, dis_2))
+        {
+            if (dis_1 + dis_2 < shortest[vertice_2])
+            {
+                shortest[vertice_2] = dis_1 + dis_2;
+                parent[vertice_2] = vertice_1;
+                minHeap.push(make_pair(shortest[vertice_2], vertice_2));
+            }
+        }
+    }
+}
+
+// minimum spanning tree straight over the compressed routes, no route is copied out so the only extra memory is per star
+// Boruvka rounds like euclideanMst: every component takes its cheapest route to another component, ordered by
+// (distance, from, to) as Kruskal would sort them, that order is strict so the tree is the one Kruskal picks
+vector<Edge> compressedMst(const CompressedGraph &graph)
+{
+    int n = graph.starCount();
+    IndexUnionFind unionFind(n);
+    // distance, from, to
+    vector<tuple<int, int, int>> chosen;
+    vector<tuple<int, int, int>> cheapest(n);
+    vector<bool> found(n);
+    bool merged = true;
+    while (merged && (int)chosen.size() + 1 < n)
+    {
+        fill(found.begin(), found.end(), false);
+        for (int u = 0; u < n; u++)
+        {
+            int cu = unionFind.find(u);
+            auto it = graph.neighbours(u);
+            int v, distance;
+            while (it.next(v, distance))
+            {
+                int cv = unionFind.find(v);
+                if (cu == cv)
+                {
+                    continue;
+                }
+                // routes are undirected for the tree, so the route is a candidate for both components
+                tuple<int, int, int> route = make_tuple(distance, u, v);
+                for (int c : {cu, cv})
+                {
+                    if (!found[c] || route < cheapest[c])
+                    {
+                        cheapest[c] = route;
+                        found[c] = true;
+                    }
+                }
+            }
+        }
+
+        merged = false;
+        for (int c = 0; c < n; c++)
+        {
+            if (found[c] && unionFind.uni0n(get<1>(cheapest[c]), get<2>(cheapest[c])))
+            {
+                chosen.push_back(cheapest[c]);
+                merged = true;
+            }
+        }
+    }
+
+    // ascending like Kruskal reports them
+    sort(chosen.begin(), chosen.end());
+    vector<Edge> mst;
+    for (const auto &[distance, u, v] : chosen)
+    {
+        mst.push_back(Edge{graph.name(u), graph.name(v), distance});
+    }
+    return mst;
+}
+
+// rough heap footprint of the Edge list and of the adjacency list shortestPath builds,
+// strings up to 15 characters are stored inline (libstdc++ small string optimisation)
+size_t stringHeapBytes(const string &s)
+{
+    return s.size() > 15 ? s.capacity() + 1 : 0;
+}
+
+size_t edgeListBytes(const vector<Edge> &edges)
+{
+    size_t total = edges.capacity() * sizeof(Edge);
+    for (const auto &edge : edges)
+    {
+        total += stringHeapBytes(edge.star1) + stringHeapBytes(edge.star2);
+    }
+    return total;
+}
+
+size_t adjacencyBytes(const unordered_map<string, vector<pair<string, int>>> &adj)
+{
+    // each entry is a heap node holding the key, the value, the next pointer and the cached hash
+    size_t total = adj.bucket_count() * sizeof(void *);
+    for (const auto &[star, neighbours] : adj)
+    {
+        total += sizeof(pair<const string, vector<pair<string, int>>>) + 2 * sizeof(void *) + stringHeapBytes(star);
+        total += neighbours.capacity() * sizeof(pair<string, int>);
+        for (const auto &[neighbour, distance] : neighbours)
+        {
+            total += stringHeapBytes(neighbour);
+        }
+    }
+    return total;
+}
+
+int main()
+{
+    int sortingChoice = 0;
+
+    vector<Star> stars;
+    vector<Edge> edges;
+    // dataset is only parsed on a cache miss
+    string fingerprint = datasetFingerprint("Q1_dataset_2.txt");
+
+    cout << "1. Dijkstra's Algorithm (Shortest Path)" << endl;
+    cout << "2. Minimum Spanning Tree (Prim's Algorithm up to 64 stars, Kruskal's Algorithm above)" << endl;
+    cout << "3. Yen's Algorithm (K Shortest Paths)" << endl;
+    cout << "4. Euclidean Minimum Spanning Tree (from star coordinates)" << endl;
+    cout << "5. Compressed Graph (memory and traversal benchmark)" << endl;
+    cout << "6. Exit" << endl;
+    cout << "Enter Option: ";
+    cin >> sortingChoice;
+
+    if (sortingChoice == 6)
+    {
+        return 0;
+    }
+    if (sortingChoice < 1 || sortingChoice > 5)
+    {
+        cout << "Invalid sorting algorithm, please try again." << endl;
+        return 1;
+    }
+
+    /*Code for verifying if vector is read*/
+    /*
+    cout << "List of Stars: " << endl;
     for (const auto &star : stars)
     {
         cout << star.name << " " << star.x << " " << star.y << " " << star.z << " " << star.weight << " " << star.profit << endl;
@@ -337,29 +2126,67 @@ int main()
     {
         auto start_krus = chrono::high_resolution_clock::now();
         vector<string> vertices = {"A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O", "P", "Q", "R", "S","T"};
+        StageTimes times;
 
-        vector<Edge> mstEdges = mst(edges, vertices);
+        vector<Edge> mstEdges;
+        // the algorithm that produced the tree, cached under its own key so a cache hit reports it too
+        string algorithm = "Kruskal's";
+        bool denseSolved = false;
+        string cached;
+        if (cacheRead("prim", "all", fingerprint, cached) || cacheRead("kruskal", "all", fingerprint, cached))
+        {
+            algorithm = filesystem::exists(cachePath("prim", "all", fingerprint)) ? "Prim's" : "Kruskal's";
+            cout << "Loaded " << algorithm << " result from cache" << endl;
+            cout << endl;
+            mstEdges = deserializeEdges(cached);
+        }
+        else
+        {
+            // kruskal only needs the edge list
+            unordered_map<string, vector<pair<string, int>>> adj;
+            pipelinedReader("Q1_dataset_2.txt", stars, edges, adj, false, times);
+            auto start_solve = high_resolution_clock::now();
+            // small star maps take the dense fast path
+            denseSolved = denseMst(edges, vertices, mstEdges);
+            if (denseSolved)
+            {
+                algorithm = "Prim's";
+            }
+            else
+            {
+                mstEdges = mst(edges, vertices);
+            }
+            times.solve = msSince(start_solve);
+            cacheWrite(algorithm == "Prim's" ? "prim" : "kruskal", "all", fingerprint, serializeEdges(mstEdges));
+        }
         auto end_krus = chrono::high_resolution_clock::now();
         chrono::duration<double, milli> krus_duration = end_krus - start_krus;
+        if (denseSolved)
+        {
+            denseMstRecord(edges, vertices);
+        }
 
-        cout << "Result for Minimum Spanning Tree: " << endl;
-        ofstream outputFile("Q3_krus_results.txt");
+        AsyncWriter writer("Q3_krus_results.txt");
+        writer.emit("Result for Minimum Spanning Tree (" + algorithm + " Algorithm): \n", "");
         for (const auto &edge : mstEdges)
         {
-            cout << "[" << edge.star1 << " - " << edge.star2 << "]  Distance: " << edge.distance << endl;
-            // Write result to txt file
-            outputFile << "[" << edge.star1 << " - " << edge.star2 << "]  Distance: " << edge.distance << endl;
+            // Write result to console and txt file
+            string line = "[" + edge.star1 + " - " + edge.star2 + "]  Distance: " + to_string(edge.distance) + "\n";
+            writer.emit(line, line);
         }
-        cout << endl;
-        cout << "Kruskal's Algorithm Program Runtime: " << krus_duration.count() << " ms" << endl;
-        outputFile << endl;
-        outputFile << "Kruskal's Algorithm Program Runtime: " << krus_duration.count() << " ms" << endl;
+        ostringstream runtime;
+        runtime << "\n" << algorithm << " Algorithm Program Runtime: " << krus_duration.count() << " ms\n";
+        writer.emit(runtime.str(), runtime.str());
+        writer.finish();
+        times.write = writer.busyMs();
+        printStageTimes(times);
     }
     else if (sortingChoice == 1)
     {
         auto start_dij = chrono::high_resolution_clock::now();
         vector<string> vertices = {"A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O", "P","Q", "R", "S","T"};
         string src = "A";
+        StageTimes times;
         // unordered_map<string, int> result = shortestPath(edges, src);
 
         // To store predecessors of each vertex
@@ -371,43 +2198,314 @@ int main()
             predecessors[vertex] = "";
         }
 
-        unordered_map<string, int> result = shortestPath(edges, vertices, src, predecessors, weights);
+        unordered_map<string, int> result;
+        bool denseSolved = false;
+        string cached;
+        if (cacheRead("dijkstra", src, fingerprint, cached))
+        {
+            cout << "Loaded Dijkstra result from cache" << endl;
+            cout << endl;
+            deserializeShortestPaths(cached, result, predecessors, weights);
+        }
+        else
+        {
+            unordered_map<string, vector<pair<string, int>>> adj;
+            // the adjacency list is only needed when the dense fast path cannot take the graph
+            bool dense = vertices.size() <= 64;
+            pipelinedReader("Q1_dataset_2.txt", stars, edges, adj, !dense, times);
+            auto start_solve = high_resolution_clock::now();
+            denseSolved = denseShortestPath(edges, vertices, src, result, predecessors, weights);
+            if (!denseSolved)
+            {
+                if (dense)
+                {
+                    for (const auto &edge : edges)
+                    {
+                        adj[edge.star1].push_back(make_pair(edge.star2, edge.distance));
+                    }
+                }
+                result = shortestPath(adj, src, predecessors, weights);
+            }
+            times.solve = msSince(start_solve);
+            cacheWrite("dijkstra", src, fingerprint, serializeShortestPaths(result, predecessors, weights));
+        }
         auto end_dij = chrono::high_resolution_clock::now();
         chrono::duration<double, milli> dij_duration = end_dij - start_dij;
+        if (denseSolved)
+        {
+            denseShortestPathRecord(edges, vertices, src);
+        }
 
-        ofstream outputFile("Q3_dijk_results.txt");
-        cout << "Shortest paths from node " << src << ":\n";
-        outputFile << "Shortest paths from node " << src << endl;
+        AsyncWriter writer("Q3_dijk_results.txt");
+        writer.emit("Shortest paths from node " + src + ":\n", "Shortest paths from node " + src + "\n");
 
+        // each path is reconstructed while the writer is still printing the previous one
         for (const auto &[node, distance] : result)
         {
-            cout << "To node " << node << " is at distance " << distance << "\n";
-            outputFile << "To node " << node << " is at distance " << distance << "\n";
+            ostringstream oss;
+            oss << "To node " << node << " is at distance " << distance << "\n";
 
             // call path contructor
             vector<pair<string, int>> path = reconstructPath(predecessors, weights , node);
-            cout << "Path: ";
-            outputFile << "Path: ";
+            oss << "Path: ";
             for (const auto& [p, w] : path)
             {
-                cout << p << "(" << w << ") ";
-                outputFile << p << "(" << w << ") ";
+                oss << p << "(" << w << ") ";
             }
-            cout << "\n";
+            oss << "\n\n";
+            writer.emit(oss.str(), oss.str());
+        }
+
+        ostringstream runtime;
+        runtime << "\nDijkstra Algorithm Program Runtime: " << dij_duration.count() << " ms\n";
+        writer.emit(runtime.str(), runtime.str());
+        writer.finish();
+        times.write = writer.busyMs();
+        printStageTimes(times);
+    }
+    else if (sortingChoice == 3)
+    {
+        string src, target;
+        long long k = 0;
+        cout << "Enter source star: ";
+        cin >> src;
+        cout << "Enter target star: ";
+        cin >> target;
+        cout << "Enter number of paths (k): ";
+        // read signed so -1 is rejected instead of wrapping to every path, nothing is solved or cached for a bad k
+        if (!(cin >> k) || k < 1)
+        {
+            cout << "Invalid number of paths, please try again." << endl;
+            return 1;
+        }
+        cout << endl;
+
+        auto start_yen = chrono::high_resolution_clock::now();
+        StageTimes times;
+        vector<WeightedPath> paths;
+        string params = src + "-" + target + "-" + to_string(k);
+        string cached;
+        if (cacheRead("yen", params, fingerprint, cached))
+        {
+            cout << "Loaded Yen result from cache" << endl;
             cout << endl;
+            paths = deserializePaths(cached);
+        }
+        else
+        {
+            unordered_map<string, vector<pair<string, int>>> adj;
+            pipelinedReader("Q1_dataset_2.txt", stars, edges, adj, true, times);
+            auto start_solve = high_resolution_clock::now();
+            paths = kShortestPaths(adj, src, target, k);
+            times.solve = msSince(start_solve);
+            cacheWrite("yen", params, fingerprint, serializePaths(paths));
+        }
+        auto end_yen = chrono::high_resolution_clock::now();
+        chrono::duration<double, milli> yen_duration = end_yen - start_yen;
 
-            outputFile << endl;
-            outputFile << endl;
+        AsyncWriter writer("Q3_yen_results.txt");
+        string header = "K shortest paths from node " + src + " to node " + target + ":\n";
+        writer.emit(header, header);
+        if (paths.empty())
+        {
+            string none = "No path found\n";
+            writer.emit(none, none);
+        }
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            ostringstream oss;
+            oss << "Path " << i + 1 << " (distance " << paths[i].distance << "): ";
+            for (const auto &[p, w] : paths[i].stars)
+            {
+                oss << p << "(" << w << ") ";
+            }
+            oss << "\n";
+            writer.emit(oss.str(), oss.str());
         }
 
-        cout << endl;
-        cout << "Dijkstra Algorithm Program Runtime: " << dij_duration.count() << " ms" << endl;
-        outputFile << endl;
-        outputFile << "Dijkstra Algorithm Program Runtime: " << dij_duration.count() << " ms" << endl;
+        ostringstream runtime;
+        runtime << "\nYen's Algorithm Program Runtime: " << yen_duration.count() << " ms\n";
+        writer.emit(runtime.str(), runtime.str());
+        writer.finish();
+        times.write = writer.busyMs();
+        printStageTimes(times);
     }
-    else if (sortingChoice == 3)
+
+    else if (sortingChoice == 4)
     {
-        return 0;
+        auto start_emst = chrono::high_resolution_clock::now();
+        StageTimes times;
+
+        vector<Edge> mstEdges;
+        string cached;
+        if (cacheRead("emst", "all", fingerprint, cached))
+        {
+            cout << "Loaded Euclidean MST result from cache" << endl;
+            cout << endl;
+            mstEdges = deserializeEdges(cached);
+        }
+        else
+        {
+            // only the star coordinates are used, routes are ignored
+            unordered_map<string, vector<pair<string, int>>> adj;
+            pipelinedReader("Q1_dataset_2.txt", stars, edges, adj, false, times);
+            if (!coordinatesInRange(stars))
+            {
+                cerr << "Star coordinates span more than " << MAX_COORDINATE_SPAN << " on an axis, distances would not fit an int" << endl;
+                return 1;
+            }
+            auto start_solve = high_resolution_clock::now();
+            mstEdges = euclideanMst(stars);
+            times.solve = msSince(start_solve);
+            cacheWrite("emst", "all", fingerprint, serializeEdges(mstEdges));
+        }
+        auto end_emst = chrono::high_resolution_clock::now();
+        chrono::duration<double, milli> emst_duration = end_emst - start_emst;
+
+        AsyncWriter writer("Q3_emst_results.txt");
+        writer.emit("Result for Euclidean Minimum Spanning Tree: \n", "");
+        long long total = 0;
+        for (const auto &edge : mstEdges)
+        {
+            string line = "[" + edge.star1 + " - " + edge.star2 + "]  Distance: " + to_string(edge.distance) + "\n";
+            writer.emit(line, line);
+            total += edge.distance;
+        }
+        ostringstream summary;
+        summary << "\nTotal distance: " << total << "\n";
+        summary << "Euclidean MST Program Runtime: " << emst_duration.count() << " ms\n";
+        writer.emit(summary.str(), summary.str());
+        writer.finish();
+        times.write = writer.busyMs();
+        printStageTimes(times);
+    }
+
+    else if (sortingChoice == 5)
+    {
+        // the uncompressed layouts need all of their memory, skip them for graphs that only fit compressed
+        string compare;
+        cout << "Compare with the edge list and adjacency list layouts (y/n): ";
+        cin >> compare;
+        cout << endl;
+        bool compareLayouts = compare != "n" && compare != "N";
+
+        StageTimes times;
+        // routes go from the parser straight into the builder, the Edge list is never held
+        CompressedGraphBuilder builder;
+        pipelinedReader(
+            "Q1_dataset_2.txt", stars, [&](const vector<Edge> &chunk)
+            { builder.add(chunk); },
+            times);
+        auto start_build = high_resolution_clock::now();
+        CompressedGraph graph = builder.finish();
+        times.build += msSince(start_build);
+
+        // scan every route of each layout enough times for a stable measurement
+        const uint64_t routes = max<uint64_t>(graph.routeCount(), 1);
+        const int repeat = max<uint64_t>(1, 20000000 / routes);
+        long long checksum = 0;
+
+        auto start_scan = high_resolution_clock::now();
+        for (int r = 0; r < repeat; r++)
+        {
+            for (int u = 0; u < graph.starCount(); u++)
+            {
+                auto it = graph.neighbours(u);
+                int v, distance;
+                while (it.next(v, distance))
+                {
+                    checksum += distance;
+                }
+            }
+        }
+        double compressedMs = msSince(start_scan);
+
+        auto start_solve = high_resolution_clock::now();
+        vector<int> shortest, parent;
+        int src = graph.indexOf("A");
+        int reached = 0;
+        if (src != -1)
+        {
+            compressedShortestPath(graph, src, shortest, parent);
+            reached = count_if(shortest.begin(), shortest.end(), [](int d)
+                               { return d != NO_ROUTE; });
+        }
+        double dijkstraMs = msSince(start_solve);
+        auto start_mst = high_resolution_clock::now();
+        vector<Edge> mstEdges = compressedMst(graph);
+        double mstMs = msSince(start_mst);
+        times.solve = msSince(start_solve);
+        long long mstTotal = 0;
+        for (const auto &edge : mstEdges)
+        {
+            mstTotal += edge.distance;
+        }
+
+        // the uncompressed layouts are read separately, after the compressed graph is done with
+        double edgeListBytesPerRoute = 0.0, adjacencyBytesPerRoute = 0.0, edgeListMs = 0.0, adjacencyMs = 0.0;
+        if (compareLayouts)
+        {
+            vector<Star> comparisonStars;
+            unordered_map<string, vector<pair<string, int>>> adj;
+            StageTimes comparisonTimes;
+            pipelinedReader("Q1_dataset_2.txt", comparisonStars, edges, adj, true, comparisonTimes);
+            edgeListBytesPerRoute = double(edgeListBytes(edges)) / routes;
+            adjacencyBytesPerRoute = double(adjacencyBytes(adj)) / routes;
+
+            start_scan = high_resolution_clock::now();
+            for (int r = 0; r < repeat; r++)
+            {
+                for (const auto &edge : edges)
+                {
+                    checksum += edge.distance;
+                }
+            }
+            edgeListMs = msSince(start_scan);
+
+            start_scan = high_resolution_clock::now();
+            for (int r = 0; r < repeat; r++)
+            {
+                for (const auto &[star, neighbours] : adj)
+                {
+                    for (const auto &[neighbour, distance] : neighbours)
+                    {
+                        checksum += distance;
+                    }
+                }
+            }
+            adjacencyMs = msSince(start_scan);
+        }
+
+        auto throughput = [&](double ms)
+        {
+            return to_string(ms > 0 ? routes * repeat / (ms * 1000.0) : 0.0) + " million routes/s";
+        };
+        ostringstream oss;
+        oss << "Compressed graph: " << graph.starCount() << " stars, " << graph.routeCount() << " routes, "
+            << graph.weightWidth() << " byte distances\n\n";
+        oss << "Bytes per route:\n";
+        if (compareLayouts)
+        {
+            oss << "Edge list: " << edgeListBytesPerRoute << "\n";
+            oss << "Adjacency list: " << adjacencyBytesPerRoute << "\n";
+        }
+        oss << "Compressed: " << double(graph.bytes()) / routes << "\n\n";
+        oss << "Traversal throughput (" << repeat << " full scans):\n";
+        if (compareLayouts)
+        {
+            oss << "Edge list: " << throughput(edgeListMs) << "\n";
+            oss << "Adjacency list: " << throughput(adjacencyMs) << "\n";
+        }
+        oss << "Compressed: " << throughput(compressedMs) << "\n";
+        oss << "Checksum: " << checksum << "\n\n";
+        oss << "Dijkstra from A on compressed graph: " << dijkstraMs << " ms, " << reached << " stars reached\n";
+        oss << "Minimum spanning tree (Boruvka, Kruskal's tree) on compressed graph: " << mstMs << " ms, " << mstEdges.size() << " edges, total distance " << mstTotal << "\n";
+
+        AsyncWriter writer("Q3_compressed_results.txt");
+        writer.emit(oss.str(), oss.str());
+        writer.finish();
+        times.write = writer.busyMs();
+        printStageTimes(times);
     }
 
     return 0;
@@ -9,6 +9,16 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+// result cache
+#include <filesystem>
+#include <cstdint>
+// writer stage
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+// batched knapsack
+#include <atomic>
+#include <random>
 
 using namespace std;
 using namespace chrono;
@@ -81,6 +91,279 @@ void fileReader(const string &dataSet2, vector<Star> &stars, vector<Edge> &edges
     file.close();
 }
 
+// Pipeline
+// the dp table is handed to a writer thread row by row so printing overlaps with formatting the next row
+double msSince(const high_resolution_clock::time_point &start)
+{
+    duration<double, milli> elapsed = high_resolution_clock::now() - start;
+    return elapsed.count();
+}
+
+// push blocks while the queue is full so a fast stage cannot run far ahead of a slow one
+template <typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+    void push(T item)
+    {
+        unique_lock<mutex> lock(m);
+        notFull.wait(lock, [this]
+                     { return items.size() < capacity; });
+        items.push(move(item));
+        notEmpty.notify_one();
+    }
+
+    // returns false once the queue is closed and fully drained
+    bool pop(T &item)
+    {
+        unique_lock<mutex> lock(m);
+        notEmpty.wait(lock, [this]
+                      { return !items.empty() || closed; });
+        if (items.empty())
+        {
+            return false;
+        }
+        item = move(items.front());
+        items.pop();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        lock_guard<mutex> lock(m);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    queue<T> items;
+    bool closed = false;
+    mutex m;
+    condition_variable notEmpty, notFull;
+};
+
+// writer stage, the main thread formats text and this thread does the blocking console and file writes
+class AsyncWriter
+{
+public:
+    AsyncWriter(const string &fileName) : outputFile(fileName), lines(256), worker([this]
+                                                                                   { run(); }) {}
+
+    ~AsyncWriter()
+    {
+        finish();
+    }
+
+    void emit(string console, string file)
+    {
+        lines.push(make_pair(move(console), move(file)));
+    }
+
+    // wait for everything queued so far to be written
+    void finish()
+    {
+        if (worker.joinable())
+        {
+            lines.close();
+            worker.join();
+        }
+    }
+
+    double busyMs() const
+    {
+        return busy;
+    }
+
+private:
+    void run()
+    {
+        pair<string, string> line;
+        while (lines.pop(line))
+        {
+            auto start = high_resolution_clock::now();
+            cout << line.first;
+            outputFile << line.second;
+            busy += msSince(start);
+        }
+        cout.flush();
+        outputFile.flush();
+    }
+
+    ofstream outputFile;
+    BoundedQueue<pair<string, string>> lines;
+    double busy = 0.0;
+    // declared last so the thread starts after the members it uses
+    thread worker;
+};
+
+// Result cache
+// results are stored on disk keyed by algorithm, parameters and a hash of the dataset bytes
+// so a rerun on an unchanged dataset skips solving entirely
+const string CACHE_DIR = "result_cache";
+const size_t CACHE_MAX_ENTRIES = 32;
+// part of every key, bump it whenever a solver or a serialize format changes so old entries stop matching
+const string CACHE_VERSION = "v2";
+
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+// FNV-1a hash of the raw dataset file, changes whenever any byte of the dataset changes
+string datasetFingerprint(const string &dataSet2)
+{
+    ifstream file(dataSet2, ios::binary);
+    if (!file.is_open())
+    {
+        cerr << "Error opening txt file" << endl;
+        exit(1);
+    }
+    uint64_t hash = FNV_OFFSET;
+    char buffer[4096];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+    {
+        for (streamsize i = 0; i < file.gcount(); i++)
+        {
+            hash ^= static_cast<unsigned char>(buffer[i]);
+            hash *= FNV_PRIME;
+        }
+    }
+    ostringstream oss;
+    oss << hex << hash;
+    return oss.str();
+}
+
+string cachePath(const string &algo, const string &params, const string &fingerprint)
+{
+    return CACHE_DIR + "/" + algo + "_" + params + "_" + fingerprint + "_" + CACHE_VERSION + ".txt";
+}
+
+// FNV-1a of an entry's contents, stored in its first line so a torn or truncated entry is detected
+string contentsChecksum(const string &contents)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (char c : contents)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= FNV_PRIME;
+    }
+    ostringstream oss;
+    oss << hex << hash;
+    return oss.str();
+}
+
+bool cacheRead(const string &algo, const string &params, const string &fingerprint, string &contents)
+{
+    string path = cachePath(algo, params, fingerprint);
+    ifstream file(path, ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    // first line is "checksum size", the contents follow
+    string header, checksum;
+    size_t size = 0;
+    getline(file, header);
+    istringstream(header) >> checksum >> size;
+    ostringstream oss;
+    oss << file.rdbuf();
+    contents = oss.str();
+    file.close();
+    error_code ec;
+    if (checksum.empty() || contents.size() != size || contentsChecksum(contents) != checksum)
+    {
+        // a damaged entry is a miss, remove it so the next run rewrites it
+        filesystem::remove(path, ec);
+        contents.clear();
+        return false;
+    }
+    // touch the entry so it counts as most recently used
+    filesystem::last_write_time(path, filesystem::file_time_type::clock::now(), ec);
+    return true;
+}
+
+void cacheWrite(const string &algo, const string &params, const string &fingerprint, const string &contents)
+{
+    error_code ec;
+    filesystem::create_directories(CACHE_DIR, ec);
+
+    // drop entries of the same query computed from an older dataset or cache version
+    string prefix = algo + "_" + params + "_";
+    string current = filesystem::path(cachePath(algo, params, fingerprint)).filename().string();
+    vector<pair<filesystem::file_time_type, filesystem::path>> entries;
+    for (const auto &entry : filesystem::directory_iterator(CACHE_DIR, ec))
+    {
+        string name = entry.path().filename().string();
+        if (name.rfind(prefix, 0) == 0 && name != current)
+        {
+            filesystem::remove(entry.path(), ec);
+            continue;
+        }
+        entries.push_back(make_pair(entry.last_write_time(ec), entry.path()));
+    }
+
+    // LRU eviction, remove least recently used entries until there is room for the new one
+    sort(entries.begin(), entries.end());
+    for (size_t i = 0; i + CACHE_MAX_ENTRIES <= entries.size(); i++)
+    {
+        filesystem::remove(entries[i].second, ec);
+    }
+
+    // write a private temp file and rename it over the entry, readers only ever see a complete entry
+    string path = cachePath(algo, params, fingerprint);
+    string temp = path + "." + to_string(hash<thread::id>()(this_thread::get_id())) + "_" + to_string(steady_clock::now().time_since_epoch().count()) + ".tmp";
+    {
+        ofstream file(temp, ios::binary);
+        file << contentsChecksum(contents) << " " << contents.size() << "\n" << contents;
+        file.flush();
+        if (!file)
+        {
+            file.close();
+            filesystem::remove(temp, ec);
+            return;
+        }
+    }
+    filesystem::rename(temp, path, ec);
+    if (ec)
+    {
+        filesystem::remove(temp, ec);
+    }
+}
+
+// first line holds the table size, then one row of the table per line
+string serializeTable(const vector<vector<int>> &table)
+{
+    ostringstream oss;
+    oss << table.size() << " " << (table.empty() ? 0 : table[0].size()) << "\n";
+    for (const auto &row : table)
+    {
+        for (int val : row)
+        {
+            oss << val << " ";
+        }
+        oss << "\n";
+    }
+    return oss.str();
+}
+
+vector<vector<int>> deserializeTable(const string &contents)
+{
+    istringstream iss(contents);
+    size_t rows = 0, cols = 0;
+    iss >> rows >> cols;
+    vector<vector<int>> table(rows, vector<int>(cols, 0));
+    for (auto &row : table)
+    {
+        for (int &val : row)
+        {
+            iss >> val;
+        }
+    }
+    return table;
+}
+
 // 0/1 Knapsack
 vector<vector<int>> dp(vector<int> &profit, vector<int> &weight, int capacity)
 {
@@ -170,11 +453,290 @@ vector<int> matrixGenerator(vector<vector<int>> &dp, vector<int> &weight, vector
     return items;
 }
 
-int main()
+// Batched Knapsack
+// many small independent instances stored flat, instance i owns items [offset[i], offset[i + 1])
+struct KnapsackBatch
+{
+    vector<int> capacity;
+    vector<int> offset = {0};
+    vector<int> weight;
+    vector<int> profit;
+
+    size_t size() const
+    {
+        return capacity.size();
+    }
+
+    void add(const vector<int> &instanceWeight, const vector<int> &instanceProfit, int instanceCapacity)
+    {
+        capacity.push_back(instanceCapacity);
+        weight.insert(weight.end(), instanceWeight.begin(), instanceWeight.end());
+        profit.insert(profit.end(), instanceProfit.begin(), instanceProfit.end());
+        offset.push_back(weight.size());
+    }
+};
+
+// answers in the same flat layout, taken[offset[i] + j] is 1 when item j of instance i is packed
+struct KnapsackBatchResult
+{
+    vector<int> maxProfit;
+    vector<unsigned char> taken;
+};
+
+// an instance whose table would exceed this many cells (about 200 MB of ints) is skipped when reading
+const long long BATCH_MAX_CELLS = 50000000;
+
+// per worker scratch table, it only ever grows so once it fits the largest instance nothing more is allocated
+struct KnapsackArena
 {
+    vector<int> table;
+};
+
+void solveInstance(const KnapsackBatch &batch, size_t index, KnapsackArena &arena, KnapsackBatchResult &result)
+{
+    int begin = batch.offset[index];
+    int N = batch.offset[index + 1] - begin, M = batch.capacity[index];
+    size_t width = M + 1;
+    if (arena.table.size() < (N + 1) * width)
+    {
+        arena.table.resize((N + 1) * width);
+    }
+
+    // row 0 is the empty selection, row i + 1 may use items 0..i
+    int *table = arena.table.data();
+    fill(table, table + width, 0);
+    for (int i = 0; i < N; i++)
+    {
+        const int *skip = table + i * width;
+        int *row = table + (i + 1) * width;
+        int w = batch.weight[begin + i], p = batch.profit[begin + i];
+        int split = min(w, M + 1);
+        // below the item's weight it cannot be packed, above it the loop has no branch so the compiler vectorizes it
+        copy(skip, skip + split, row);
+        for (int c = split; c <= M; c++)
+        {
+            row[c] = max(skip[c], skip[c - w] + p);
+        }
+    }
+    result.maxProfit[index] = table[N * width + M];
+
+    // walk the table back like matrixGenerator
+    int c = M;
+    for (int i = N; i > 0; i--)
+    {
+        bool packed = table[i * width + c] != table[(i - 1) * width + c];
+        result.taken[begin + i - 1] = packed;
+        if (packed)
+        {
+            c -= batch.weight[begin + i - 1];
+        }
+    }
+}
+
+struct BatchStats
+{
+    double totalMs;
+    double instancesPerSecond;
+};
+
+// workers take chunks of instances off a shared counter, each with its own arena
+BatchStats batchKnapsack(const KnapsackBatch &batch, KnapsackBatchResult &result, int workers)
+{
+    result.maxProfit.assign(batch.size(), 0);
+    result.taken.assign(batch.weight.size(), 0);
+    const size_t CHUNK = 64;
+    atomic<size_t> next(0);
+
+    auto start = high_resolution_clock::now();
+    vector<thread> threads;
+    for (int w = 0; w < workers; w++)
+    {
+        threads.emplace_back([&]()
+                             {
+            KnapsackArena arena;
+            while (true)
+            {
+                size_t first = next.fetch_add(CHUNK);
+                if (first >= batch.size())
+                {
+                    break;
+                }
+                size_t last = min(first + CHUNK, batch.size());
+                for (size_t i = first; i < last; i++)
+                {
+                    solveInstance(batch, i, arena, result);
+                }
+            } });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    BatchStats stats;
+    stats.totalMs = msSince(start);
+    stats.instancesPerSecond = stats.totalMs > 0 ? batch.size() / (stats.totalMs / 1000.0) : 0.0;
+    return stats;
+}
+
+// checks one line, on failure returns why and leaves the instance unread
+string parseInstance(const string &line, int &capacity, vector<int> &weight, vector<int> &profit)
+{
+    istringstream iss(line);
+    int count;
+    if (!(iss >> capacity >> count))
+    {
+        return "expected capacity and count";
+    }
+    if (capacity < 0 || count < 0)
+    {
+        return "negative capacity or count";
+    }
+    if ((count + 1LL) * (capacity + 1LL) > BATCH_MAX_CELLS)
+    {
+        return "table larger than " + to_string(BATCH_MAX_CELLS) + " cells";
+    }
+    weight.assign(count, 0);
+    profit.assign(count, 0);
+    for (int i = 0; i < count; i++)
+    {
+        if (!(iss >> weight[i] >> profit[i]))
+        {
+            return "expected " + to_string(2 * count) + " weights and profits";
+        }
+        if (weight[i] < 0 || profit[i] < 0)
+        {
+            return "negative weight or profit";
+        }
+    }
+    string extra;
+    if (iss >> extra)
+    {
+        return "unexpected value " + extra;
+    }
+    return "";
+}
+
+// one instance per line: capacity count weight profit weight profit ...
+// malformed lines are skipped and reported, blank lines are ignored
+KnapsackBatch readBatch(istream &in)
+{
+    KnapsackBatch batch;
+    string line;
+    vector<int> weight, profit;
+    int lineNumber = 0, skipped = 0;
+    while (getline(in, line))
+    {
+        lineNumber++;
+        if (line.find_first_not_of(" \t\r") == string::npos)
+        {
+            continue;
+        }
+        int capacity;
+        string error = parseInstance(line, capacity, weight, profit);
+        if (!error.empty())
+        {
+            cerr << "Skipping line " << lineNumber << ": " << error << endl;
+            skipped++;
+            continue;
+        }
+        batch.add(weight, profit, capacity);
+    }
+    if (skipped > 0)
+    {
+        cerr << "Skipped " << skipped << " malformed instances" << endl;
+    }
+    return batch;
+}
+
+int runBatch(const string &source)
+{
+    int count = 0;
+    if (source != "-")
+    {
+        try
+        {
+            size_t used;
+            count = stoi(source, &used);
+            if (used != source.size() || count < 1)
+            {
+                throw invalid_argument(source);
+            }
+        }
+        catch (const exception &)
+        {
+            cerr << "Usage: ./Q4 --batch <count|->" << endl;
+            return 1;
+        }
+    }
+
+    KnapsackBatch batch;
+    if (source == "-")
+    {
+        batch = readBatch(cin);
+    }
+    else
+    {
+        // the dataset's stars first, then random instances of the same shape (values 0..99 like Q1_data2.cpp)
+        vector<Star> stars;
+        vector<Edge> edges;
+        fileReader("Q1_dataset_2.txt", stars, edges);
+        vector<int> weight, profit;
+        for (const auto &star : stars)
+        {
+            weight.push_back(star.weight);
+            profit.push_back(star.profit);
+        }
+        mt19937 rng(2024);
+        uniform_int_distribution<int> value(0, 99);
+        for (int i = 0; i < count; i++)
+        {
+            batch.add(weight, profit, 800);
+            for (size_t j = 0; j < weight.size(); j++)
+            {
+                weight[j] = value(rng);
+                profit[j] = value(rng);
+            }
+        }
+    }
+
+    int workers = max(1u, thread::hardware_concurrency());
+    KnapsackBatchResult result;
+    BatchStats stats = batchKnapsack(batch, result, workers);
+
+    ofstream outputFile("Q4_batch_results.txt");
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        outputFile << "Instance " << i << ": Maximum benefit " << result.maxProfit[i] << ", items:";
+        for (int j = batch.offset[i]; j < batch.offset[i + 1]; j++)
+        {
+            if (result.taken[j])
+            {
+                outputFile << " " << j - batch.offset[i];
+            }
+        }
+        outputFile << "\n";
+    }
+    outputFile.close();
+
+    cout << "Solved " << batch.size() << " instances on " << workers << " threads in " << stats.totalMs << " ms" << endl;
+    cout << "Throughput: " << stats.instancesPerSecond << " instances/s" << endl;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // ./Q4 --batch <count> solves count generated instances, ./Q4 --batch - reads instances from stdin
+    if (argc >= 2 && string(argv[1]) == "--batch")
+    {
+        return runBatch(argc >= 3 ? argv[2] : "10000");
+    }
+
     vector<Star> stars;
     vector<Edge> edges;
+    auto start_load = high_resolution_clock::now();
     fileReader("Q1_dataset_2.txt", stars, edges);
+    double loadMs = msSince(start_load);
 
     // we only need weight and profit data for stars
     /*
@@ -211,45 +773,60 @@ int main()
     cout << endl;
     
 
+    // hash the dataset before the timer starts, like Q3, so the reported runtime is the solve alone
+    string fingerprint = datasetFingerprint("Q1_dataset_2.txt");
     auto start = chrono::high_resolution_clock::now();
-    // call Knapsack function
-    vector<vector<int>> knapsack = dp(profit, weight, capacity);
+    // call Knapsack function, or reuse the table from a previous run on the same dataset
+    vector<vector<int>> knapsack;
+    string cached;
+    bool cacheHit = cacheRead("knapsack", to_string(capacity), fingerprint, cached);
+    if (cacheHit)
+    {
+        cout << "Loaded Knapsack table from cache" << endl;
+        cout << endl;
+        knapsack = deserializeTable(cached);
+    }
+    else
+    {
+        knapsack = dp(profit, weight, capacity);
+    }
     auto end = chrono::high_resolution_clock::now();
     chrono::duration<double, milli> knap_program_duration = end - start;
+    if (!cacheHit)
+    {
+        cacheWrite("knapsack", to_string(capacity), fingerprint, serializeTable(knapsack));
+    }
 
-    ofstream outputFile("Q4_knap_results.txt");
+    AsyncWriter writer("Q4_knap_results.txt");
 
     // Display table matrix
-    cout << "Knapsack DP Table: " << endl;
-    cout << "   ";
-    outputFile << "Knapsack DP Table: " << endl;
-    outputFile << "   ";
+    ostringstream header;
+    header << "Knapsack DP Table: \n";
+    header << "   ";
     // row 
     for (int c = 0; c <= capacity; c++)
     {
-        cout << c << " ";
-        outputFile << c << " ";
+        header << c << " ";
     }
-    cout << endl;
-    outputFile << endl;
+    header << "\n";
+    writer.emit(header.str(), header.str());
 
     // column
     for (int i = 0; i < knapsack.size(); i++)
     {
-        cout << i << ": ";
-        outputFile << i << ": ";
+        ostringstream line;
+        line << i << ": ";
         for (int c = 0; c <= capacity; c++)
         {
             // values from matrix
-            cout << knapsack[i][c] << " ";
-            outputFile << knapsack[i][c] << " ";
+            line << knapsack[i][c] << " ";
         }
-        cout << endl;
-        outputFile << endl;
+        line << "\n";
+        writer.emit(line.str(), line.str());
     }
 
 
-    cout << "Knapsack Matrix: " << endl;
+    writer.emit("Knapsack Matrix: \n", "");
     // print out knapsack
     /*
     for (const auto& row : knapsack)
@@ -269,31 +846,23 @@ int main()
     string vertices = "A"; // Initialize vertices string with 'A'
     for (const auto &row : knapsack)
     {
-        cout << "Stars involved: " << endl;
-        cout << endl;
-
-        outputFile << "Stars involved: " << endl;
-        outputFile << endl;
+        ostringstream block;
+        block << "Stars involved: \n";
+        block << "\n";
 
         for (size_t i = 0; i < vertices.size(); ++i)
         {
-            cout << vertices[i] << " (Weight: " << weight[vertices[i] - 'A'] << ", Profit: " << profit[vertices[i] - 'A'] << ") | \n";
-            cout << endl;
-
-            outputFile << vertices[i] << " (Weight: " << weight[vertices[i] - 'A'] << ", Profit: " << profit[vertices[i] - 'A'] << ") | \n";
-            outputFile<< endl;
+            block << vertices[i] << " (Weight: " << weight[vertices[i] - 'A'] << ", Profit: " << profit[vertices[i] - 'A'] << ") | \n";
+            block << "\n";
         }
 
         for (int val : row)
         {
-            cout << val << " ";
-            outputFile << val << " ";
+            block << val << " ";
         }
-        cout << endl;
-        cout << endl;
-
-        outputFile << endl;
-        outputFile << endl;
+        block << "\n";
+        block << "\n";
+        writer.emit(block.str(), block.str());
 
         if (vertices.size() < knapsack.size())
         {
@@ -302,21 +871,21 @@ int main()
     }
 
     vector<int> items = matrixGenerator(knapsack, weight, profit, capacity);
-    cout << endl;
-    cout << "Stars included: " << endl;
-    outputFile << "Stars included: " << endl;
+    ostringstream included;
+    included << "Stars included: \n";
     for (int item : items)
     {
-        cout << stars[item].name << " (Weight: " << stars[item].weight << ", Profit: " << stars[item].profit << ")" << endl;
-        outputFile << stars[item].name << " (Weight: " << stars[item].weight << ", Profit: " << stars[item].profit << ")" << endl;
+        included << stars[item].name << " (Weight: " << stars[item].weight << ", Profit: " << stars[item].profit << ")\n";
     }
+    included << " Maximum benefit: " << knapsack[profit.size() - 1][capacity] << "\n";
+    writer.emit("\n" + included.str(), included.str());
 
-    cout << " Maximum benefit: " << knapsack[profit.size() - 1][capacity] << endl;
-    cout << "0/1 Knapsack Program Runtime: " << knap_program_duration.count();
+    ostringstream runtime;
+    runtime << "0/1 Knapsack Program Runtime: " << knap_program_duration.count();
+    writer.emit(runtime.str(), runtime.str() + " ms");
+    writer.finish();
 
-    outputFile << " Maximum benefit: " << knapsack[profit.size() - 1][capacity] << endl;
-    outputFile << "0/1 Knapsack Program Runtime: " << knap_program_duration.count() << " ms";
-
-    outputFile.close();
+    cout << endl;
+    cout << "Stage times: load " << loadMs << " ms, solve " << knap_program_duration.count() << " ms, write " << writer.busyMs() << " ms" << endl;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,1048 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <queue>
+#include <deque>
+// file reading and writing
+#include <fstream>
+#include <sstream>
+#include <string>
+// worker pool
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+// unix domain socket
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+
+using namespace std;
+using namespace chrono;
+
+/*
+Resident query server
+loads Q1_dataset_2.txt once and answers queries until stdin closes (or forever in socket mode)
+
+    ./Q5_server                                  line protocol on stdin/stdout
+    ./Q5_server serve <socket> [dataset]         line protocol on a unix domain socket
+    ./Q5_server client <socket>                  send stdin lines to a running server
+    ./Q5_server loadgen <socket> [requests] [connections]
+
+Requests, one per line, every response ends with a line "END":
+    sp <src> [target]     Dijkstra shortest paths from src
+    mst                   Kruskal minimum spanning tree
+    knap [capacity]       0/1 knapsack over star weight and profit, capacity defaults to 800
+                          and the table is limited to KNAPSACK_MAX_CELLS cells
+    reload [dataset]      load a dataset and swap it in, queries already running finish on the old one
+    stats                 per-request latency histograms
+    quit                  close this connection
+*/
+
+struct Star
+{
+    string name;
+    int x, y, z, weight, profit;
+};
+
+struct Edge
+{
+    string star1;
+    string star2;
+    int distance;
+};
+
+// parse a single dataset line into a star or an edge, readingEdges flips once the routes header is seen
+void parseLine(const string &line, bool &readingEdges, vector<Star> &stars, vector<Edge> &edges)
+{
+    if (line.empty())
+        return;
+
+    // if true, read route data (edges)
+    if (line == "Routes (edges):")
+    {
+        readingEdges = true;
+        return;
+    }
+    // if false, read star data (vertices)
+    if (!readingEdges)
+    {
+        Star star;
+        istringstream iss(line);
+
+        // Parse star data
+        getline(iss, star.name, '\t');
+        iss >> star.x >> star.y >> star.z >> star.weight >> star.profit;
+
+        stars.push_back(star);
+    }
+    else
+    {
+        Edge edge;
+        istringstream iss(line);
+        string temp;
+
+        // Parse edge data
+        // temp to replace symbols
+        getline(iss, edge.star1, ' ');
+        iss >> edge.star1 >> temp >> temp >> edge.star2 >> temp >> edge.distance;
+
+        edges.push_back(edge);
+    }
+}
+
+// a knapsack table larger than this (about 200 MB of ints) is refused instead of allocated
+const long long KNAPSACK_MAX_CELLS = 50000000;
+// the memo of a snapshot is dropped once it holds this many answers
+const size_t MEMO_MAX_ENTRIES = 4096;
+
+// Snapshot
+// everything a query needs, built once per dataset and never modified afterwards
+struct Snapshot
+{
+    string source;
+    vector<Star> stars;
+    vector<Edge> edges;
+    // single letter names used by the routes, e.g. "A" for "Star A"
+    vector<string> vertices;
+    unordered_map<string, vector<pair<string, int>>> adj;
+    // sum of star weights, any knapsack capacity above it packs the same stars
+    long long totalWeight = 0;
+
+    // answers already computed on this snapshot, keyed by the parsed request
+    mutable mutex memoLock;
+    mutable unordered_map<string, string> memo;
+};
+
+// unlike fileReader in Q3/Q4 a bad path must not take the server down, so failure returns nullptr
+shared_ptr<const Snapshot> loadSnapshot(const string &dataSet2)
+{
+    ifstream file(dataSet2);
+    if (!file.is_open())
+    {
+        return nullptr;
+    }
+    auto snapshot = make_shared<Snapshot>();
+    snapshot->source = dataSet2;
+
+    string line;
+    bool readingEdges = false;
+    // skip header
+    getline(file, line);
+    while (getline(file, line))
+    {
+        parseLine(line, readingEdges, snapshot->stars, snapshot->edges);
+    }
+
+    for (const auto &star : snapshot->stars)
+    {
+        snapshot->vertices.push_back(star.name.substr(star.name.find_last_of(' ') + 1));
+        snapshot->totalWeight += max(star.weight, 0);
+    }
+    for (const auto &edge : snapshot->edges)
+    {
+        snapshot->adj[edge.star1].push_back(make_pair(edge.star2, edge.distance));
+    }
+    return snapshot;
+}
+
+// holds the current snapshot, readers take their own reference so a swap never invalidates a running query
+class SnapshotStore
+{
+public:
+    SnapshotStore(shared_ptr<const Snapshot> initial) : current(move(initial)) {}
+
+    shared_ptr<const Snapshot> get()
+    {
+        lock_guard<mutex> lock(m);
+        return current;
+    }
+
+    void swap(shared_ptr<const Snapshot> next)
+    {
+        lock_guard<mutex> lock(m);
+        current = move(next);
+    }
+
+private:
+    mutex m;
+    shared_ptr<const Snapshot> current;
+};
+
+// Union-Find (Disjoint Set)
+class UnionFind
+{
+public:
+    unordered_map<string, string> parent;
+    unordered_map<string, int> rank;
+
+    UnionFind(const vector<string> &vertices)
+    {
+        for (const auto &vertex : vertices)
+        {
+            parent[vertex] = vertex;
+            rank[vertex] = 0;
+        }
+    }
+
+    string find(const string &n)
+    {
+        // Path Compression
+        if (parent[n] != n)
+        {
+            parent[n] = find(parent[n]);
+        }
+        return parent[n];
+    }
+
+    bool uni0n(const string &n1, const string &n2)
+    {
+        string p1 = find(n1), p2 = find(n2);
+        if (p1 == p2)
+        {
+            return false;
+        }
+        if (rank[p1] > rank[p2])
+        {
+            parent[p2] = p1;
+        }
+        else if (rank[p1] < rank[p2])
+        {
+            parent[p1] = p2;
+        }
+        else
+        {
+            parent[p1] = p2;
+            rank[p2] += 1;
+        }
+        return true;
+    }
+};
+
+// Queries
+// same algorithms as Q3 and Q4, without the per-step timing and runtime files
+
+string answerShortestPath(const Snapshot &snapshot, const string &src, const string &target)
+{
+    if (find(snapshot.vertices.begin(), snapshot.vertices.end(), src) == snapshot.vertices.end())
+    {
+        return "ERROR unknown star " + src + "\n";
+    }
+    unordered_map<string, int> shortest;
+    unordered_map<string, string> predecessors;
+    unordered_map<string, int> weights;
+    priority_queue<pair<int, string>, vector<pair<int, string>>, greater<pair<int, string>>> minHeap;
+    minHeap.push(make_pair(0, src));
+    predecessors[src] = "";
+
+    while (!minHeap.empty())
+    {
+        auto [dis_1, vertice_1] = minHeap.top();
+        minHeap.pop();
+        if (shortest.count(vertice_1) > 0)
+        {
+            continue;
+        }
+        shortest[vertice_1] = dis_1;
+
+        auto it = snapshot.adj.find(vertice_1);
+        if (it == snapshot.adj.end())
+        {
+            continue;
+        }
+        for (const auto &[vertice_2, dis_2] : it->second)
+        {
+            if (shortest.count(vertice_2) == 0)
+            {
+                minHeap.push(make_pair(dis_1 + dis_2, vertice_2));
+                predecessors[vertice_2] = vertice_1;
+                weights[vertice_2] = dis_2;
+            }
+        }
+    }
+
+    // backtrack from node to src, in the Star(weight) format of Q3
+    auto pathTo = [&](const string &node)
+    {
+        vector<pair<string, int>> path;
+        for (string at = node; !at.empty(); at = predecessors.at(at))
+        {
+            path.push_back(make_pair(at, predecessors.at(at).empty() ? 0 : weights.at(at)));
+        }
+        reverse(path.begin(), path.end());
+        ostringstream oss;
+        oss << "Path: ";
+        for (const auto &[p, w] : path)
+        {
+            oss << p << "(" << w << ") ";
+        }
+        return oss.str();
+    };
+
+    ostringstream oss;
+    vector<string> targets;
+    if (!target.empty())
+    {
+        if (shortest.count(target) == 0)
+        {
+            return "ERROR no path from " + src + " to " + target + "\n";
+        }
+        targets.push_back(target);
+    }
+    else
+    {
+        for (const auto &vertex : snapshot.vertices)
+        {
+            if (shortest.count(vertex) > 0)
+            {
+                targets.push_back(vertex);
+            }
+        }
+    }
+    for (const auto &node : targets)
+    {
+        oss << "To node " << node << " is at distance " << shortest[node] << "\n";
+        oss << pathTo(node) << "\n";
+    }
+    return oss.str();
+}
+
+string answerMst(const Snapshot &snapshot)
+{
+    auto comp = [](const Edge &e1, const Edge &e2)
+    {
+        return e1.distance > e2.distance;
+    };
+    priority_queue<Edge, vector<Edge>, decltype(comp)> minHeap(comp);
+    for (const auto &edge : snapshot.edges)
+    {
+        minHeap.push(edge);
+    }
+
+    UnionFind unionFind(snapshot.vertices);
+    vector<Edge> mst;
+    while (mst.size() + 1 < snapshot.vertices.size() && !minHeap.empty())
+    {
+        Edge cur = minHeap.top();
+        minHeap.pop();
+        if (unionFind.uni0n(cur.star1, cur.star2))
+        {
+            mst.push_back(cur);
+        }
+    }
+
+    ostringstream oss;
+    int total = 0;
+    for (const auto &edge : mst)
+    {
+        oss << "[" << edge.star1 << " - " << edge.star2 << "]  Distance: " << edge.distance << "\n";
+        total += edge.distance;
+    }
+    oss << "Total distance: " << total << "\n";
+    return oss.str();
+}
+
+string answerKnapsack(const Snapshot &snapshot, int capacity)
+{
+    if (capacity < 0 || snapshot.stars.empty())
+    {
+        return "ERROR invalid capacity\n";
+    }
+    const auto &stars = snapshot.stars;
+    int N = stars.size(), M = (int)min<long long>(capacity, snapshot.totalWeight);
+    if ((long long)N * (M + 1) > KNAPSACK_MAX_CELLS)
+    {
+        return "ERROR capacity too large for " + to_string(N) + " stars\n";
+    }
+    vector<vector<int>> dp(N, vector<int>(M + 1, 0));
+    for (int c = 0; c <= M; c++)
+    {
+        if (stars[0].weight <= c)
+        {
+            dp[0][c] = stars[0].profit;
+        }
+    }
+    for (int i = 1; i < N; i++)
+    {
+        for (int c = 1; c <= M; c++)
+        {
+            int skip = dp[i - 1][c];
+            int include = 0;
+            if (c - stars[i].weight >= 0)
+            {
+                include = stars[i].profit + dp[i - 1][c - stars[i].weight];
+            }
+            dp[i][c] = max(include, skip);
+        }
+    }
+
+    // walk the table back to the chosen stars, as matrixGenerator in Q4
+    vector<int> items;
+    int c = M;
+    for (int i = N - 1; i > 0; i--)
+    {
+        if (dp[i][c] != dp[i - 1][c])
+        {
+            items.push_back(i);
+            c -= stars[i].weight;
+        }
+    }
+    if (c >= stars[0].weight)
+    {
+        items.push_back(0);
+    }
+
+    ostringstream oss;
+    oss << "Stars included: \n";
+    for (int item : items)
+    {
+        oss << stars[item].name << " (Weight: " << stars[item].weight << ", Profit: " << stars[item].profit << ")\n";
+    }
+    oss << " Maximum benefit: " << dp[N - 1][M] << "\n";
+    return oss.str();
+}
+
+// Latency histogram
+// power of two buckets in microseconds, bucket i holds latencies in [2^(i-1), 2^i)
+class LatencyHistogram
+{
+public:
+    static const int BUCKETS = 32;
+
+    void record(double us)
+    {
+        int bucket = 0;
+        while (bucket < BUCKETS - 1 && us >= double(1ULL << bucket))
+        {
+            bucket++;
+        }
+        lock_guard<mutex> lock(m);
+        counts[bucket]++;
+        total++;
+        maxUs = max(maxUs, us);
+    }
+
+    string report(const string &name)
+    {
+        lock_guard<mutex> lock(m);
+        ostringstream oss;
+        oss << name << ": count " << total;
+        if (total == 0)
+        {
+            oss << "\n";
+            return oss.str();
+        }
+        oss << ", p50 < " << percentile(0.50) << " us, p90 < " << percentile(0.90) << " us, p99 < " << percentile(0.99) << " us, max " << maxUs << " us\n";
+        for (int i = 0; i < BUCKETS; i++)
+        {
+            if (counts[i] > 0)
+            {
+                oss << "  < " << (1ULL << i) << " us: " << counts[i] << "\n";
+            }
+        }
+        return oss.str();
+    }
+
+private:
+    // upper bound of the bucket holding the given fraction of requests
+    unsigned long long percentile(double fraction)
+    {
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++)
+        {
+            seen += counts[i];
+            if (seen >= fraction * total)
+            {
+                return 1ULL << i;
+            }
+        }
+        return 1ULL << (BUCKETS - 1);
+    }
+
+    mutex m;
+    uint64_t counts[BUCKETS] = {};
+    uint64_t total = 0;
+    double maxUs = 0.0;
+};
+
+// push blocks while the queue is full so a fast producer cannot run far ahead of its consumer
+template <typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+    void push(T item)
+    {
+        unique_lock<mutex> lock(m);
+        notFull.wait(lock, [this]
+                     { return items.size() < capacity; });
+        items.push_back(move(item));
+        notEmpty.notify_one();
+    }
+
+    // returns false once the queue is closed and fully drained
+    bool pop(T &item)
+    {
+        unique_lock<mutex> lock(m);
+        notEmpty.wait(lock, [this]
+                      { return !items.empty() || closed; });
+        if (items.empty())
+        {
+            return false;
+        }
+        item = move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    // take the front item plus up to maxItems - 1 queued items that same() says match it,
+    // everything else stays queued for the other consumers, blocks only until the first one is available
+    template <typename Same>
+    bool popBatch(vector<T> &batch, size_t maxItems, Same same)
+    {
+        unique_lock<mutex> lock(m);
+        notEmpty.wait(lock, [this]
+                      { return !items.empty() || closed; });
+        if (items.empty())
+        {
+            return false;
+        }
+        batch.push_back(move(items.front()));
+        items.pop_front();
+        for (auto it = items.begin(); it != items.end() && batch.size() < maxItems;)
+        {
+            if (same(batch.front(), *it))
+            {
+                batch.push_back(move(*it));
+                it = items.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        notFull.notify_all();
+        return true;
+    }
+
+    void close()
+    {
+        lock_guard<mutex> lock(m);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    deque<T> items;
+    bool closed = false;
+    mutex m;
+    condition_variable notEmpty, notFull;
+};
+
+// Query server
+// a fixed pool of workers takes requests in batches of identical request lines, each batch is answered once
+struct Request
+{
+    string line;
+    promise<string> response;
+    high_resolution_clock::time_point received;
+};
+
+class QueryServer
+{
+public:
+    QueryServer(shared_ptr<const Snapshot> initial, size_t workerCount, size_t batchSize)
+        : store(move(initial)), requests(1024), batchSize(batchSize)
+    {
+        for (size_t i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back([this]
+                                 { workerLoop(); });
+        }
+    }
+
+    ~QueryServer()
+    {
+        requests.close();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    future<string> submit(const string &line)
+    {
+        auto request = make_shared<Request>();
+        request->line = line;
+        request->received = high_resolution_clock::now();
+        future<string> response = request->response.get_future();
+        requests.push(move(request));
+        return response;
+    }
+
+private:
+    void workerLoop()
+    {
+        vector<shared_ptr<Request>> batch;
+        auto sameLine = [](const shared_ptr<Request> &first, const shared_ptr<Request> &other)
+        {
+            return first->line == other->line;
+        };
+        while (requests.popBatch(batch, batchSize, sameLine))
+        {
+            // every request in the batch is the same line, so it is answered once against one snapshot
+            // and the other requests stay queued for idle workers instead of waiting behind this one
+            shared_ptr<const Snapshot> snapshot = store.get();
+            const string &line = batch.front()->line;
+            string command;
+            istringstream(line) >> command;
+            string answer;
+            try
+            {
+                answer = handle(line, command, snapshot);
+            }
+            catch (const exception &e)
+            {
+                // a failing request still gets a response, and the worker keeps serving
+                answer = string("ERROR ") + e.what() + "\n";
+            }
+            for (auto &request : batch)
+            {
+                duration<double, micro> latency = high_resolution_clock::now() - request->received;
+                histogramFor(command).record(latency.count());
+                request->response.set_value(answer);
+            }
+            batch.clear();
+        }
+    }
+
+    string handle(const string &line, const string &command, const shared_ptr<const Snapshot> &snapshot)
+    {
+        if (command == "stats")
+        {
+            return spLatency.report("sp") + mstLatency.report("mst") + knapLatency.report("knap") + reloadLatency.report("reload");
+        }
+        if (command == "reload")
+        {
+            istringstream iss(line);
+            string temp, dataSet2;
+            iss >> temp >> dataSet2;
+            if (dataSet2.empty())
+            {
+                dataSet2 = snapshot->source;
+            }
+            shared_ptr<const Snapshot> next = loadSnapshot(dataSet2);
+            if (!next)
+            {
+                return "ERROR cannot open " + dataSet2 + "\n";
+            }
+            store.swap(next);
+            return "Reloaded " + dataSet2 + ": " + to_string(next->stars.size()) + " stars, " + to_string(next->edges.size()) + " routes\n";
+        }
+
+        istringstream iss(line);
+        string temp;
+        iss >> temp;
+        // parse first so the memo key is the normalized request, not the raw line
+        string key, src, target;
+        int capacity = 800;
+        if (command == "sp")
+        {
+            iss >> src >> target;
+            key = "sp " + src + " " + target;
+        }
+        else if (command == "mst")
+        {
+            key = "mst";
+        }
+        else if (command == "knap")
+        {
+            string argument;
+            if (iss >> argument)
+            {
+                istringstream number(argument);
+                if (!(number >> capacity) || !number.eof() || capacity < 0)
+                {
+                    return "ERROR invalid capacity: " + argument + "\n";
+                }
+            }
+            capacity = (int)min<long long>(capacity, snapshot->totalWeight);
+            key = "knap " + to_string(capacity);
+        }
+        else
+        {
+            return "ERROR unknown request: " + line + "\n";
+        }
+
+        // answers never change for a snapshot, so repeated queries are served from its memo
+        {
+            lock_guard<mutex> lock(snapshot->memoLock);
+            auto it = snapshot->memo.find(key);
+            if (it != snapshot->memo.end())
+            {
+                return it->second;
+            }
+        }
+        string answer;
+        if (command == "sp")
+        {
+            answer = answerShortestPath(*snapshot, src, target);
+        }
+        else if (command == "mst")
+        {
+            answer = answerMst(*snapshot);
+        }
+        else
+        {
+            answer = answerKnapsack(*snapshot, capacity);
+        }
+        lock_guard<mutex> lock(snapshot->memoLock);
+        if (snapshot->memo.size() >= MEMO_MAX_ENTRIES)
+        {
+            snapshot->memo.clear();
+        }
+        snapshot->memo[key] = answer;
+        return answer;
+    }
+
+    LatencyHistogram &histogramFor(const string &command)
+    {
+        if (command == "sp")
+            return spLatency;
+        if (command == "mst")
+            return mstLatency;
+        if (command == "knap")
+            return knapLatency;
+        if (command == "reload")
+            return reloadLatency;
+        return otherLatency;
+    }
+
+    SnapshotStore store;
+    BoundedQueue<shared_ptr<Request>> requests;
+    size_t batchSize;
+    LatencyHistogram spLatency, mstLatency, knapLatency, reloadLatency, otherLatency;
+    vector<thread> workers;
+};
+
+// Connections
+// requests from one connection are answered in the order they arrived,
+// a responder thread waits on each answer while the reader keeps submitting the next requests
+void serveConnection(QueryServer &server, function<bool(string &)> readLine, function<bool(const string &)> writeText)
+{
+    BoundedQueue<future<string>> pending(256);
+    thread responder([&]()
+                     {
+        future<string> answer;
+        bool open = true;
+        while (pending.pop(answer))
+        {
+            string text = answer.get() + "END\n";
+            if (open)
+            {
+                open = writeText(text);
+            }
+        } });
+
+    string line;
+    while (readLine(line))
+    {
+        if (line == "quit")
+        {
+            break;
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+        pending.push(server.submit(line));
+    }
+    pending.close();
+    responder.join();
+}
+
+bool writeAll(int fd, const string &text)
+{
+    size_t sent = 0;
+    while (sent < text.size())
+    {
+        ssize_t n = send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+// buffered line reader over a socket
+class SocketLineReader
+{
+public:
+    SocketLineReader(int fd) : fd(fd) {}
+
+    bool readLine(string &line)
+    {
+        while (true)
+        {
+            size_t end = buffer.find('\n');
+            if (end != string::npos)
+            {
+                line = buffer.substr(0, end);
+                buffer.erase(0, end + 1);
+                return true;
+            }
+            char chunk[4096];
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0)
+            {
+                return false;
+            }
+            buffer.append(chunk, n);
+        }
+    }
+
+private:
+    int fd;
+    string buffer;
+};
+
+sockaddr_un socketAddress(const string &path)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+}
+
+int connectTo(const string &path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = socketAddress(path);
+    if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        cerr << "Error connecting to " << path << endl;
+        exit(1);
+    }
+    return fd;
+}
+
+// read one full response, the lines up to END
+bool readResponse(SocketLineReader &reader, string &response)
+{
+    response.clear();
+    string line;
+    while (reader.readLine(line))
+    {
+        if (line == "END")
+        {
+            return true;
+        }
+        response += line + "\n";
+    }
+    return false;
+}
+
+int runSocketServer(QueryServer &server, const string &path)
+{
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = socketAddress(path);
+    unlink(path.c_str());
+    if (listener < 0 || bind(listener, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener, 64) < 0)
+    {
+        cerr << "Error listening on " << path << endl;
+        return 1;
+    }
+    cerr << "Listening on " << path << endl;
+
+    // one thread per connection, they only read, submit and write so the worker pool does the computing
+    while (true)
+    {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0)
+        {
+            continue;
+        }
+        thread([&server, fd]()
+               {
+            SocketLineReader reader(fd);
+            serveConnection(
+                server, [&reader](string &line)
+                { return reader.readLine(line); },
+                [fd](const string &text)
+                { return writeAll(fd, text); });
+            close(fd); })
+            .detach();
+    }
+}
+
+int runClient(const string &path)
+{
+    int fd = connectTo(path);
+    SocketLineReader reader(fd);
+    string line, response;
+    while (getline(cin, line))
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+        if (!writeAll(fd, line + "\n"))
+        {
+            break;
+        }
+        if (line == "quit" || !readResponse(reader, response))
+        {
+            break;
+        }
+        cout << response << flush;
+    }
+    close(fd);
+    return 0;
+}
+
+// opens several connections and sends a mix of queries, reporting throughput and client side latency
+int runLoadGenerator(const string &path, int totalRequests, int connections)
+{
+    const vector<string> mix = {"sp A", "sp A T", "sp C", "mst", "knap 800", "knap 400"};
+    LatencyHistogram latency;
+    atomic<int> failures(0);
+
+    auto start = high_resolution_clock::now();
+    vector<thread> clients;
+    for (int c = 0; c < connections; c++)
+    {
+        clients.emplace_back([&, c]()
+                             {
+            int fd = connectTo(path);
+            SocketLineReader reader(fd);
+            string response;
+            for (int i = c; i < totalRequests; i += connections)
+            {
+                auto sent = high_resolution_clock::now();
+                if (!writeAll(fd, mix[i % mix.size()] + "\n") || !readResponse(reader, response))
+                {
+                    failures++;
+                    break;
+                }
+                if (response.rfind("ERROR", 0) == 0)
+                {
+                    failures++;
+                }
+                duration<double, micro> elapsed = high_resolution_clock::now() - sent;
+                latency.record(elapsed.count());
+            }
+            close(fd); });
+    }
+    for (auto &client : clients)
+    {
+        client.join();
+    }
+    duration<double, milli> total = high_resolution_clock::now() - start;
+
+    cout << "Requests: " << totalRequests << " over " << connections << " connections in " << total.count() << " ms" << endl;
+    cout << "Throughput: " << totalRequests / (total.count() / 1000.0) << " requests/s" << endl;
+    cout << "Failures: " << failures << endl;
+    cout << latency.report("round trip");
+
+    // server side view
+    int fd = connectTo(path);
+    SocketLineReader reader(fd);
+    string response;
+    writeAll(fd, "stats\n");
+    readResponse(reader, response);
+    cout << "Server histograms:" << endl;
+    cout << response;
+    close(fd);
+    return failures == 0 ? 0 : 1;
+}
+
+// a whole positive number, anything else is a usage error
+bool parseCount(const string &text, int &count)
+{
+    try
+    {
+        size_t used;
+        count = stoi(text, &used);
+        return used == text.size() && count >= 1;
+    }
+    catch (const exception &)
+    {
+        return false;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    vector<string> args(argv + 1, argv + argc);
+    string mode = args.empty() ? "stdin" : args[0];
+    const size_t workerCount = max(2u, thread::hardware_concurrency());
+    const size_t batchSize = 16;
+
+    if (mode == "client" && args.size() >= 2)
+    {
+        return runClient(args[1]);
+    }
+    if (mode == "loadgen" && args.size() >= 2)
+    {
+        int totalRequests = 10000, connections = 8;
+        if ((args.size() >= 3 && !parseCount(args[2], totalRequests)) || (args.size() >= 4 && !parseCount(args[3], connections)))
+        {
+            cerr << "Usage: Q5_server loadgen <socket> [requests] [connections]" << endl;
+            return 1;
+        }
+        return runLoadGenerator(args[1], totalRequests, connections);
+    }
+
+    string dataSet2 = "Q1_dataset_2.txt";
+    if (mode == "serve" && args.size() >= 3)
+    {
+        dataSet2 = args[2];
+    }
+    else if (mode != "serve" && mode != "stdin")
+    {
+        cerr << "Usage: Q5_server [serve <socket> [dataset] | client <socket> | loadgen <socket> [requests] [connections]]" << endl;
+        return 1;
+    }
+
+    shared_ptr<const Snapshot> snapshot = loadSnapshot(dataSet2);
+    if (!snapshot)
+    {
+        cerr << "Error opening txt file" << endl;
+        exit(1);
+    }
+    QueryServer server(snapshot, workerCount, batchSize);
+
+    if (mode == "serve")
+    {
+        if (args.size() < 2)
+        {
+            cerr << "Usage: Q5_server serve <socket> [dataset]" << endl;
+            return 1;
+        }
+        return runSocketServer(server, args[1]);
+    }
+
+    serveConnection(
+        server, [](string &line)
+        { return bool(getline(cin, line)); },
+        [](const string &text)
+        {
+            cout << text << flush;
+            return true;
+        });
+    return 0;
+}